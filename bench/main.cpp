@@ -0,0 +1,351 @@
+/*
+ * Microbenchmarks of the primitives in common.h.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <getopt.h>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include "../common/common.h"
+
+using namespace std;
+
+/* the number of different operands every primitive is called with in turn */
+#define OPERANDS 64
+/* the number of different primes is_prime is called with, finding large
+ * primes takes long so there are fewer of them */
+#define PRIMES 4
+
+/* this function keeps the compiler from optimising the computation of x away */
+template<typename T> static inline void keep(const T &x)
+{
+    __asm__ __volatile__("" : : "g"(&x) : "memory");
+}
+
+/* the operands of one benchmark row, converted to the number type */
+template<typename number> struct operands
+{
+    number base;
+    /* random numbers with bits bits */
+    vector<number> n;
+    /* PRIMES primes with bits bits */
+    vector<number> primes;
+    /* two factors with half the digits of n each, like at the deepest level of
+     * the digit-by-digit search */
+    vector<number> a, b;
+    /* base^(digits of a - 1), the digit_base of the last digit of a */
+    vector<number> previous_base;
+    vector<digit_counter> current_digit;
+    /* base^k for a random k below the number of digits of n */
+    vector<number> digit_base;
+    vector<digit> digits;
+};
+
+/* this function returns a random number with exactly bits bits */
+static mpz_class random_bits(gmp_randstate_t state, unsigned int bits)
+{
+    mpz_class low = 1;
+
+    low <<= bits - 1;
+
+    return my_rand(state, low, 2 * low - 1);
+}
+
+/* this function returns PRIMES primes with bits bits (the next prime after a
+ * number in the lower three quarters of the range does not leave the range) */
+static vector<mpz_class> create_primes(gmp_randstate_t state, unsigned int bits)
+{
+    vector<mpz_class> primes(PRIMES);
+
+    for(unsigned int i = 0;i < PRIMES;i++)
+    {
+        mpz_nextprime(primes[i].get_mpz_t(), my_rand(state, mpz_class(1) << (bits - 1), mpz_class(3) << (bits - 2)).get_mpz_t());
+    }
+
+    return primes;
+}
+
+template<typename number> static operands<number> create_operands(gmp_randstate_t state, const mpz_class &base, unsigned int bits, const vector<mpz_class> &primes)
+{
+    operands<number> ops;
+
+    ops.base = from_mpz<number>(base);
+
+    for(unsigned int i = 0;i < PRIMES;i++)
+    {
+        ops.primes.push_back(from_mpz<number>(primes[i]));
+    }
+
+    for(unsigned int i = 0;i < OPERANDS;i++)
+    {
+        mpz_class n = random_bits(state, bits);
+        digit_counter digits = num_of_digits(n, base);
+        digit_counter half = (digits + 1) / 2;
+        mpz_class half_base = my_pow(base, half);
+
+        ops.n.push_back(from_mpz<number>(n));
+        ops.a.push_back(from_mpz<number>(my_rand(state, 1, half_base - 1)));
+        ops.b.push_back(from_mpz<number>(my_rand(state, 1, half_base - 1)));
+        ops.current_digit.push_back(half - 1);
+        ops.previous_base.push_back(from_mpz<number>(my_pow(base, half - 1)));
+        ops.digit_base.push_back(from_mpz<number>(my_pow(base, my_rand(state, 0, digits - 1).get_ui())));
+        ops.digits.push_back(my_rand(state, 0, base - 1).get_ui());
+    }
+
+    return ops;
+}
+
+/* this function calls f(i) for i = 0, 1, ... until at least min_seconds
+ * passed and returns the nanoseconds per call */
+template<typename F> static double measure(double min_seconds, unsigned long int &iterations, F f)
+{
+    for(iterations = 1;;iterations *= 2)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+        for(unsigned long int i = 0;i < iterations;i++)
+        {
+            f(i % OPERANDS);
+        }
+
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        if(seconds >= min_seconds)
+        {
+            return 1e9 * seconds / iterations;
+        }
+    }
+}
+
+static void print_row(const char *primitive, const char *type, const mpz_class &base, unsigned int bits, unsigned long int iterations, double ns)
+{
+    char line[256];
+
+    snprintf(line, sizeof(line), "%s,%s,%lu,%u,%lu,%.3f", primitive, type, base.get_ui(), bits, iterations, ns);
+    cout << line << endl;
+}
+
+/* this function writes the rows of all primitives for one number type */
+template<typename number> static void bench_type(const char *type, gmp_randstate_t state, const mpz_class &base, unsigned int bits, const vector<mpz_class> &primes, double min_seconds, const vector<string> &primitives)
+{
+    operands<number> ops = create_operands<number>(state, base, bits, primes);
+    unsigned long int iterations;
+    double ns;
+
+    for(vector<string>::size_type k = 0;k < primitives.size();k++)
+    {
+        const string &primitive = primitives[k];
+
+        if(primitive == "check_if_new_digits_solve_digit_equation")
+        {
+            ns = measure(min_seconds, iterations, [&](unsigned int i)
+            {
+                keep(check_if_new_digits_solve_digit_equation<number>(ops.n[i], ops.a[i], ops.b[i], 0, ops.current_digit[i], ops.base, ops.previous_base[i]));
+            });
+        }
+        else if(primitive == "get_digit")
+        {
+            ns = measure(min_seconds, iterations, [&](unsigned int i)
+            {
+                keep(get_digit(ops.n[i], ops.digit_base[i], ops.base));
+            });
+        }
+        else if(primitive == "set_digit")
+        {
+            ns = measure(min_seconds, iterations, [&](unsigned int i)
+            {
+                number x = ops.a[i];
+                set_digit(x, ops.digits[i], ops.previous_base[i]);
+                keep(x);
+            });
+        }
+        else if(primitive == "find_inverse")
+        {
+            ns = measure(min_seconds, iterations, [&](unsigned int i)
+            {
+                keep(find_inverse(ops.n[i], ops.previous_base[i]));
+            });
+        }
+        else if(primitive == "num_of_digits")
+        {
+            ns = measure(min_seconds, iterations, [&](unsigned int i)
+            {
+                keep(num_of_digits(ops.n[i], ops.base));
+            });
+        }
+        else
+        {
+            ns = measure(min_seconds, iterations, [&](unsigned int i)
+            {
+                keep(is_prime(ops.primes[i % PRIMES]));
+            });
+        }
+
+        print_row(primitive.c_str(), type, base, bits, iterations, ns);
+    }
+}
+
+static const char *all_primitives[] = {
+    "check_if_new_digits_solve_digit_equation", "get_digit", "set_digit", "find_inverse", "num_of_digits", "is_prime"
+};
+
+void bench_usage(char *name)
+{
+    cout << "usage:" << endl;
+    cout << name << " [options]" << endl;
+    cout << "measures the primitives of common.h for every base, operand size and number" << endl;
+    cout << "type which can hold the operands and writes one csv line per measurement:" << endl;
+    cout << "\tprimitive,number_type,base,bits,iterations,ns_per_call" << endl;
+    cout << "options:" << endl;
+    cout << "\t-b, --bases base,..." << endl;
+    cout << "\t\tThe bases, default 2,3,10,16,256." << endl;
+    cout << "\t-s, --sizes bits,..." << endl;
+    cout << "\t\tThe operand sizes in bits, default 64,128,256,512,1024,2048,4096." << endl;
+    cout << "\t-p, --primitives primitive,..." << endl;
+    cout << "\t\tThe primitives, default check_if_new_digits_solve_digit_equation," << endl;
+    cout << "\t\tget_digit, set_digit, find_inverse, num_of_digits and is_prime." << endl;
+    cout << "\t-t, --time seconds" << endl;
+    cout << "\t\tThe minimal time of one measurement, default 0.05." << endl;
+    cout << "\t--seed seed" << endl;
+    cout << "\t\tSeeds the random number generator, default 1." << endl;
+}
+
+/* this function splits a comma separated list */
+static vector<string> split_list(const char *list)
+{
+    istringstream in(list);
+    vector<string> items;
+    string item;
+
+    while(getline(in, item, ','))
+    {
+        items.push_back(item);
+    }
+
+    return items;
+}
+
+int main(int argc, char *argv[])
+{
+    vector<string> bases = split_list("2,3,10,16,256");
+    vector<string> sizes = split_list("64,128,256,512,1024,2048,4096");
+    vector<string> primitives(all_primitives, all_primitives + sizeof(all_primitives) / sizeof(all_primitives[0]));
+    double min_seconds = 0.05;
+    unsigned long int seed = 1;
+    int opt;
+
+    static const struct option long_options[] = {
+        {"bases", required_argument, NULL, 'b'},
+        {"sizes", required_argument, NULL, 's'},
+        {"primitives", required_argument, NULL, 'p'},
+        {"time", required_argument, NULL, 't'},
+        {"seed", required_argument, NULL, 'S'},
+        {NULL, 0, NULL, 0}
+    };
+
+    while((opt = getopt_long(argc, argv, "b:s:p:t:", long_options, NULL)) != -1)
+    {
+        switch(opt)
+        {
+            case 'b':
+                bases = split_list(optarg);
+                break;
+            case 's':
+                sizes = split_list(optarg);
+                break;
+            case 'p':
+                primitives = split_list(optarg);
+                break;
+            case 't':
+                min_seconds = strtod(optarg, NULL);
+                break;
+            case 'S':
+                seed = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                bench_usage(argv[0]);
+                return -1;
+        }
+    }
+
+    if(optind != argc || min_seconds < 0)
+    {
+        bench_usage(argv[0]);
+        return -1;
+    }
+
+    for(vector<string>::size_type i = 0;i < primitives.size();i++)
+    {
+        bool known = false;
+
+        for(unsigned int j = 0;j < sizeof(all_primitives) / sizeof(all_primitives[0]);j++)
+        {
+            if(primitives[i] == all_primitives[j]) known = true;
+        }
+
+        if(!known)
+        {
+            cerr << "unknown primitive " << primitives[i] << "." << endl;
+            return -1;
+        }
+    }
+
+    gmp_randstate_t state;
+    map<unsigned int, vector<mpz_class>> primes;
+
+    gmp_randinit_default(state);
+    gmp_randseed_ui(state, seed);
+
+    cout << "primitive,number_type,base,bits,iterations,ns_per_call" << endl;
+
+    for(vector<string>::size_type i = 0;i < bases.size();i++)
+    {
+        unsigned long int base = strtoul(bases[i].c_str(), NULL, 10);
+
+        for(vector<string>::size_type j = 0;j < sizes.size();j++)
+        {
+            unsigned int bits = strtoul(sizes[j].c_str(), NULL, 10);
+
+            if(base < 2 || base >= MAX_DIGIT_BASE || bits < 8 || bit_length(mpz_class(base)) > bits)
+            {
+                cerr << "invalid base " << bases[i] << " or size " << sizes[j] << "." << endl;
+                return -1;
+            }
+
+            /* the primes do not depend on the base */
+            if(primes.count(bits) == 0)
+            {
+                primes[bits] = create_primes(state, bits);
+            }
+
+            /* the fixed width types are only measured when the operands fit */
+            if(bits <= 64) bench_type<uint64_t>("uint64", state, base, bits, primes[bits], min_seconds, primitives);
+            if(bits <= 128) bench_type<uint128>("uint128", state, base, bits, primes[bits], min_seconds, primitives);
+            if(bits <= 256) bench_type<uint256>("uint256", state, base, bits, primes[bits], min_seconds, primitives);
+            bench_type<mpz_class>("gmp", state, base, bits, primes[bits], min_seconds, primitives);
+        }
+    }
+
+    gmp_randclear(state);
+
+    return 0;
+}
@@ -0,0 +1,219 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* the choice of the base for --auto-base. the shallow part of the search tree
+ * of every candidate base is counted on the actual n and the size of the
+ * whole tree is estimated from it, the base with the least estimated work is
+ * used. */
+
+#ifndef __AUTO_BASE_H__
+#define __AUTO_BASE_H__
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include "common.h"
+#include "parallel_search.h"
+
+/* the tree of a base is probed down to the first depth k with at least
+ * PROBE_NODES nodes, but not deeper than the first depth k with
+ * base^k >= PROBE_MODULUS */
+#define PROBE_NODES 1024
+#define PROBE_MODULUS (1 << 20)
+
+/* the cache of the probes is cleared when it gets larger than this */
+#define MAX_CACHED_PROBES 65536
+
+/* the bases which are probed by choose_digit_base */
+static const digit digit_base_candidates[] = {2, 3, 4, 5, 6, 8, 10, 12, 16, 30};
+
+/* the probe of the tree of a base */
+struct base_probe
+{
+    /* the depth the tree was counted down to and its nodes there */
+    digit_counter depth;
+    uint64_t nodes;
+};
+
+/* the probes of a number type. the tree down to depth k only depends on n
+ * modulo base^k as long as 4 * base^(2 * k) <= n (there is no a * b > n
+ * and no bound_factors cut yet), so the probes are kept by base, the deepest
+ * depth k they may reach and this residue and a batch of numbers of the same
+ * residue class is only probed once. */
+template<typename number> class base_probe_cache
+{
+public:
+    bool find(const digit &base, const digit_counter &k, const number &residue, base_probe &probe)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        typename std::map<std::tuple<digit, digit_counter, number>, base_probe>::const_iterator it = probes.find(std::make_tuple(base, k, residue));
+
+        if(it == probes.end())
+        {
+            return false;
+        }
+
+        probe = it->second;
+
+        return true;
+    }
+
+    void insert(const digit &base, const digit_counter &k, const number &residue, const base_probe &probe)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        if(probes.size() >= MAX_CACHED_PROBES)
+        {
+            probes.clear();
+        }
+
+        probes[std::make_tuple(base, k, residue)] = probe;
+    }
+
+private:
+    std::mutex lock;
+    std::map<std::tuple<digit, digit_counter, number>, base_probe> probes;
+};
+
+/* this function returns the natural logarithm of x > 0, also for x beyond
+ * the range of a double */
+inline double natural_log(const mpz_class &x)
+{
+    long int exponent;
+    /* x = mantissa * 2^exponent */
+    double mantissa = mpz_get_d_2exp(&exponent, x.get_mpz_t());
+
+    return std::log(mantissa) + exponent * std::log(2.0);
+}
+
+/* search runs the complete search for the base (the first argument) through
+ * the given search_control, i.e. like the search of parallel_digit_search
+ * for the root node */
+template<typename number> using base_search = std::function<std::tuple<number, number, bool>(const number &, search_control<number> *)>;
+
+/* this function returns the logarithm of the work of the search of n with
+ * base. the probe found nodes nodes at depth k, below that every node has
+ * about base children until bound_factors closes the tree at the first depth
+ * h - 1 with base^h >= sqrt(n). so the tree has about
+ * nodes * (1 + base + ... + base^(h - 1 - k)) nodes. a node costs its base
+ * children and the base^2 pairs of digits it tries, a pair which is rejected
+ * costs pair_cost children (0 if the search solves the digit equation
+ * instead of trying pairs). */
+inline double estimated_work(const mpz_class &n, const digit &base, const base_probe &probe, const double &pair_cost)
+{
+    double log_base = std::log(static_cast<double>(base));
+    digit_counter h = static_cast<digit_counter>(std::ceil(natural_log(n) / (2 * log_base)));
+
+    /* the search ends right away */
+    if(probe.nodes == 0)
+    {
+        return -HUGE_VAL;
+    }
+
+    return std::log(static_cast<double>(probe.nodes)) + (h - 1 - std::min(probe.depth, h - 1)) * log_base + std::log(base / (base - 1.0)) + std::log(base + pair_cost * base * base);
+}
+
+/* this function chooses the base (at most max_base) for the digit-by-digit
+ * search of n and stores it in base. the tree of every candidate base is
+ * counted depth by depth (see PROBE_NODES) and the base with the smallest
+ * estimated_work (with pair_cost) is chosen. the probes only count nodes, so
+ * the choice is the same in every run. if a probe finds a factorisation
+ * (which happens for small n) it is returned, otherwise the third element of
+ * the result is false. */
+template<typename number> std::tuple<number, number, bool> choose_digit_base(const number &n, const number &max_base, const double &pair_cost, number &base, const base_search<number> &search)
+{
+    static base_probe_cache<number> cache;
+    double best = HUGE_VAL;
+
+    base = 2;
+
+    for(std::size_t i = 0;i < sizeof(digit_base_candidates) / sizeof(digit_base_candidates[0]);i++)
+    {
+        number candidate = digit_base_candidates[i];
+        number modulus = 1;
+        digit_counter k = 0;
+        base_probe probe;
+
+        if(candidate > max_base)
+        {
+            continue;
+        }
+
+        /* deeper than 4 * base^(2 * k) > n the probe would depend on all of n */
+        while(modulus < PROBE_MODULUS && 4 * (modulus * candidate) * (modulus * candidate) <= n)
+        {
+            modulus *= candidate;
+            k++;
+        }
+
+        if(k == 0)
+        {
+            continue;
+        }
+
+        if(!cache.find(digit_base_candidates[i], k, n % modulus, probe))
+        {
+            probe.depth = 0;
+            probe.nodes = 1;
+
+            while(probe.depth < k && probe.nodes > 0 && probe.nodes < PROBE_NODES)
+            {
+                std::vector<search_node<number>> frontier;
+                search_control<number> builder(probe.depth + 1, &frontier);
+                std::tuple<number, number, bool> result = search(candidate, &builder);
+
+                if(std::get<2>(result))
+                {
+                    base = candidate;
+                    return result;
+                }
+
+                probe.depth++;
+                probe.nodes = frontier.size();
+            }
+
+            cache.insert(digit_base_candidates[i], k, n % modulus, probe);
+        }
+
+        double estimate = estimated_work(to_mpz(n), digit_base_candidates[i], probe, pair_cost);
+
+#if DEBUG
+        std::cout << "base " << digit_base_candidates[i] << ": " << probe.nodes << " nodes at depth " << probe.depth << ", estimated work " << estimate << "." << std::endl;
+#endif
+
+        if(estimate < best)
+        {
+            best = estimate;
+            base = candidate;
+        }
+    }
+
+#if DEBUG
+    std::cout << "using the base " << base << "." << std::endl;
+#endif
+
+    return std::make_tuple(1, n, false);
+}
+
+#endif /* __AUTO_BASE_H__ */
@@ -0,0 +1,82 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "cancellation.h"
+
+using namespace std;
+
+cancellation_token::cancellation_token(const mpz_class &n, double seconds, uint64_t nodes, double progress)
+    : n(n), begin(chrono::steady_clock::now()), timed(seconds > 0), node_limit(nodes),
+      nodes(0), stopped(false), covered(-1), reached(0)
+{
+    deadline = begin + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds));
+    report_interval = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(progress));
+    next_report = begin + report_interval;
+}
+
+bool cancellation_token::charge(uint64_t count)
+{
+    uint64_t total = this->nodes.fetch_add(count, memory_order_relaxed) + count;
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+
+    if((node_limit != 0 && total >= node_limit) || (timed && now >= deadline))
+    {
+        stopped.store(true, memory_order_relaxed);
+    }
+
+    if(report_interval.count() > 0)
+    {
+        unique_lock<mutex> guard(report_lock, try_to_lock);
+
+        if(guard.owns_lock() && now >= next_report)
+        {
+            next_report = now + report_interval;
+            cerr << "progress of " << n << ": " << progress() << endl;
+        }
+    }
+
+    return cancelled();
+}
+
+string cancellation_token::progress() const
+{
+    ostringstream text;
+    double fraction = covered.load(memory_order_relaxed);
+    digit_counter deepest = reached.load(memory_order_relaxed);
+
+    text << fixed << setprecision(1);
+
+    if(fraction >= 0)
+    {
+        text << 100 * fraction << "% of the range, ";
+    }
+
+    if(deepest > 0)
+    {
+        text << "deepest digit " << deepest - 1 << ", ";
+    }
+
+    text << nodes.load(memory_order_relaxed) << " nodes in " << chrono::duration<double>(chrono::steady_clock::now() - begin).count() << " seconds";
+
+    return text.str();
+}
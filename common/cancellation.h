@@ -0,0 +1,101 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* the budgets of a search (--time-budget, --node-budget). the algorithms
+ * charge the work they did to a cancellation_token every few thousand nodes,
+ * candidates or iterations (every curve for ecm) and stop as soon as charge returns true,
+ * their result is trivial then and the number is reported as unknown together
+ * with the progress the token collected. the token also writes the progress
+ * lines of --progress when it is charged. */
+
+#ifndef __CANCELLATION_H__
+#define __CANCELLATION_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "common.h"
+
+/* the algorithms charge their token after this many nodes or candidates */
+#define CANCELLATION_POLL_INTERVAL 4096
+
+/* the seconds between two progress lines if a budget is given without
+ * --progress */
+#define PROGRESS_INTERVAL 10
+
+class cancellation_token
+{
+public:
+    /* the search of n stops after seconds seconds or nodes nodes (0 means no
+     * limit), every progress seconds (0 means never) a progress line is
+     * written to cerr */
+    cancellation_token(const mpz_class &n, double seconds, uint64_t nodes, double progress);
+
+    /* this function adds count nodes (search tree nodes, candidates of the
+     * trial divisions, curves or iterations, 0 only checks the deadline) to
+     * the work which was done and returns true if the search has to stop */
+    bool charge(uint64_t count);
+
+    /* this function returns true if a budget ran out */
+    bool cancelled() const
+    {
+        return stopped.load(std::memory_order_relaxed);
+    }
+
+    /* this function records the fraction of the range which was searched */
+    void cover(double fraction)
+    {
+        covered.store(fraction, std::memory_order_relaxed);
+    }
+
+    /* this function records that the search reached digit depth */
+    void reach(digit_counter depth)
+    {
+        digit_counter deepest = reached.load(std::memory_order_relaxed);
+
+        while(depth + 1 > deepest && !reached.compare_exchange_weak(deepest, depth + 1, std::memory_order_relaxed));
+    }
+
+    /* this function describes the progress of the search */
+    std::string progress() const;
+
+private:
+    mpz_class n;
+    std::chrono::steady_clock::time_point begin;
+    std::chrono::steady_clock::time_point deadline;
+    bool timed;
+    uint64_t node_limit;
+    std::chrono::steady_clock::duration report_interval;
+
+    std::atomic<uint64_t> nodes;
+    std::atomic<bool> stopped;
+    /* the fraction of the range, negative if the algorithm has no range */
+    std::atomic<double> covered;
+    /* the deepest digit plus one, 0 if the algorithm has no digits */
+    std::atomic<digit_counter> reached;
+
+    /* only one thread writes a progress line */
+    std::mutex report_lock;
+    std::chrono::steady_clock::time_point next_report;
+};
+
+#endif /* __CANCELLATION_H__ */
@@ -0,0 +1,338 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <signal.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+
+using namespace std;
+
+#define CHECKPOINT_MAGIC "IFCHECK1"
+
+atomic<bool> checkpoint_flag(false);
+atomic<bool> checkpoint_stop(false);
+
+/* the signal which stopped the search, 0 if none */
+static volatile sig_atomic_t checkpoint_signal = 0;
+
+/* the handlers only request checkpoints while a search is running */
+static atomic<bool> checkpoints_active(false);
+
+static struct sigaction previous_int, previous_term, previous_alrm;
+
+static void checkpoint_handler(int sig)
+{
+    if(sig == SIGALRM)
+    {
+        checkpoint_flag.store(true);
+        return;
+    }
+
+    /* without a running search (or the second time) the signal does what
+     * it would do without checkpoints */
+    if(!checkpoints_active.load() || checkpoint_signal != 0)
+    {
+        signal(sig, SIG_DFL);
+        raise(sig);
+        return;
+    }
+
+    checkpoint_signal = sig;
+    checkpoint_stop.store(true);
+    checkpoint_flag.store(true);
+}
+
+/* this function starts (or with interval 0 stops) the timer of the
+ * checkpoints */
+static void set_checkpoint_timer(long int interval)
+{
+    struct itimerval timer;
+
+    timer.it_interval.tv_sec = interval;
+    timer.it_interval.tv_usec = 0;
+    timer.it_value = timer.it_interval;
+
+    setitimer(ITIMER_REAL, &timer, NULL);
+}
+
+void checkpoint_writer::put(uint64_t x)
+{
+    while(x >= 0x80)
+    {
+        data += static_cast<char>((x & 0x7f) | 0x80);
+        x >>= 7;
+    }
+
+    data += static_cast<char>(x);
+}
+
+void checkpoint_writer::put(const mpz_class &x)
+{
+    size_t count = 0;
+    string bytes((mpz_sizeinbase(x.get_mpz_t(), 2) + 7) / 8, '\0');
+
+    mpz_export(&bytes[0], &count, -1, 1, -1, 0, x.get_mpz_t());
+    bytes.resize(count);
+    put(bytes);
+}
+
+void checkpoint_writer::put(const string &x)
+{
+    put(static_cast<uint64_t>(x.size()));
+    data += x;
+}
+
+uint64_t checkpoint_reader::get()
+{
+    uint64_t x = 0;
+
+    for(unsigned int shift = 0;shift < 64;shift += 7)
+    {
+        if(position >= data.size())
+        {
+            break;
+        }
+
+        unsigned char byte = data[position++];
+
+        x |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+        if((byte & 0x80) == 0)
+        {
+            return x;
+        }
+    }
+
+    failed = true;
+
+    return 0;
+}
+
+mpz_class checkpoint_reader::get_number()
+{
+    mpz_class x = 0;
+    string bytes = get_string();
+
+    if(!bytes.empty())
+    {
+        mpz_import(x.get_mpz_t(), bytes.size(), -1, 1, -1, 0, bytes.data());
+    }
+
+    return x;
+}
+
+string checkpoint_reader::get_string()
+{
+    uint64_t size = get();
+
+    if(failed || size > data.size() - position)
+    {
+        failed = true;
+        return string();
+    }
+
+    position += size;
+
+    return data.substr(position - size, size);
+}
+
+search_checkpoint::search_checkpoint(const string &file, bool resume)
+    : file(file), loaded(false), loaded_steps(0), started(false), steps(0)
+{
+    if(!resume)
+    {
+        return;
+    }
+
+    ifstream input(file.c_str(), ios::binary);
+
+    if(!input)
+    {
+        cerr << "there is no checkpoint " << file << ", starting from the beginning." << endl;
+        return;
+    }
+
+    ostringstream contents;
+    contents << input.rdbuf();
+
+    string data = contents.str();
+
+    if(data.compare(0, sizeof(CHECKPOINT_MAGIC) - 1, CHECKPOINT_MAGIC) != 0)
+    {
+        cerr << file << " is no checkpoint, starting from the beginning." << endl;
+        return;
+    }
+
+    checkpoint_reader reader(data.substr(sizeof(CHECKPOINT_MAGIC) - 1));
+
+    loaded_kind = reader.get_string();
+    loaded_n = reader.get_number();
+    loaded_base = reader.get_number();
+    loaded_steps = reader.get();
+    loaded_state = reader.get_string();
+
+    if(!reader.good() || !reader.at_end())
+    {
+        cerr << "the checkpoint " << file << " is damaged, starting from the beginning." << endl;
+        return;
+    }
+
+    loaded = true;
+}
+
+search_checkpoint::~search_checkpoint()
+{
+    finish();
+}
+
+bool search_checkpoint::find(const char *kind, const mpz_class &n, mpz_class &base, digit_counter &steps) const
+{
+    if(!loaded || loaded_kind != kind || loaded_n != n)
+    {
+        return false;
+    }
+
+    base = loaded_base;
+    steps = loaded_steps;
+
+    return true;
+}
+
+bool search_checkpoint::start(const char *kind, const mpz_class &n, const mpz_class &base, const digit_counter &steps, string &state)
+{
+    lock_guard<mutex> guard(lock);
+    bool resumed = false;
+
+    if(started)
+    {
+        return false;
+    }
+
+    if(loaded)
+    {
+        if(loaded_kind != kind || loaded_n != n || loaded_base != base || loaded_steps != steps)
+        {
+            cerr << file << " is the checkpoint of another search, it is kept and no checkpoints are written." << endl;
+            loaded = false;
+            return false;
+        }
+
+        state = loaded_state;
+        resumed = true;
+        loaded = false;
+    }
+
+    this->kind = kind;
+    this->n = n;
+    this->base = base;
+    this->steps = steps;
+    started = true;
+
+    struct sigaction action;
+
+    action.sa_handler = checkpoint_handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+
+    checkpoints_active.store(true);
+    sigaction(SIGINT, &action, &previous_int);
+    sigaction(SIGTERM, &action, &previous_term);
+    sigaction(SIGALRM, &action, &previous_alrm);
+    set_checkpoint_timer(CHECKPOINT_INTERVAL);
+
+    return resumed;
+}
+
+void search_checkpoint::save(const checkpoint_writer &state)
+{
+    lock_guard<mutex> guard(lock);
+
+    if(!started)
+    {
+        return;
+    }
+
+    checkpoint_writer contents;
+    string temporary = file + ".tmp";
+
+    contents.put(kind);
+    contents.put(n);
+    contents.put(base);
+    contents.put(static_cast<uint64_t>(steps));
+    contents.put(state.bytes());
+
+    /* the old checkpoint is only replaced by a complete new one */
+    FILE *output = fopen(temporary.c_str(), "wb");
+    bool written = output != NULL;
+
+    if(output != NULL)
+    {
+        written = fwrite(CHECKPOINT_MAGIC, 1, sizeof(CHECKPOINT_MAGIC) - 1, output) == sizeof(CHECKPOINT_MAGIC) - 1;
+        written = written && fwrite(contents.bytes().data(), 1, contents.bytes().size(), output) == contents.bytes().size();
+        written = written && fflush(output) == 0 && fsync(fileno(output)) == 0;
+        written = (fclose(output) == 0) && written;
+    }
+
+    if(!written || rename(temporary.c_str(), file.c_str()) != 0)
+    {
+        cerr << "cannot write the checkpoint " << file << "." << endl;
+        remove(temporary.c_str());
+    }
+    else if(checkpoint_signal != 0)
+    {
+        cerr << "checkpoint written to " << file << "." << endl;
+    }
+
+    if(checkpoint_signal != 0)
+    {
+        _Exit(128 + checkpoint_signal);
+    }
+}
+
+void search_checkpoint::finish()
+{
+    lock_guard<mutex> guard(lock);
+
+    if(!started)
+    {
+        return;
+    }
+
+    set_checkpoint_timer(0);
+    sigaction(SIGALRM, &previous_alrm, NULL);
+    sigaction(SIGTERM, &previous_term, NULL);
+    sigaction(SIGINT, &previous_int, NULL);
+    checkpoints_active.store(false);
+
+    remove(file.c_str());
+    started = false;
+}
+
+void search_checkpoint::reject(const char *reason)
+{
+    cerr << "the checkpoint " << file << " can't be used (" << reason << "), starting from the beginning." << endl;
+}
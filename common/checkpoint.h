@@ -0,0 +1,174 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* checkpoints of long running searches (--checkpoint file, --resume). the
+ * algorithms poll search_checkpoint::due() every few thousand candidates or
+ * nodes, it returns true every CHECKPOINT_INTERVAL seconds and when SIGINT or
+ * SIGTERM arrive. the algorithm then describes how far it got with a
+ * checkpoint_writer and passes it to search_checkpoint::save, after a signal
+ * the program exits there. a resumed algorithm reads its description back
+ * with a checkpoint_reader. */
+
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "common.h"
+
+/* the seconds between two checkpoints */
+#define CHECKPOINT_INTERVAL 60
+
+/* the trial divisions look for a due checkpoint after this many candidates */
+#define CHECKPOINT_POLL_INTERVAL 4096
+
+/* set by the timer and by the signal handlers when a checkpoint is due */
+extern std::atomic<bool> checkpoint_flag;
+
+/* set by the signal handlers, the search is stopped at the next checkpoint */
+extern std::atomic<bool> checkpoint_stop;
+
+/* the state of an algorithm as a sequence of unsigned integers and numbers,
+ * every integer is written in 7 bit groups (the lowest first, the highest bit
+ * of a byte is set if another group follows) */
+class checkpoint_writer
+{
+public:
+    void put(uint64_t x);
+    /* the length followed by the bytes, the lowest first */
+    void put(const mpz_class &x);
+    void put(const std::string &x);
+
+    const std::string &bytes() const
+    {
+        return data;
+    }
+
+private:
+    std::string data;
+};
+
+class checkpoint_reader
+{
+public:
+    explicit checkpoint_reader(const std::string &data) : data(data), position(0), failed(false) {}
+
+    uint64_t get();
+    mpz_class get_number();
+    std::string get_string();
+
+    /* this function returns true if everything could be read */
+    bool good() const
+    {
+        return !failed;
+    }
+
+    bool at_end() const
+    {
+        return position == data.size();
+    }
+
+private:
+    std::string data;
+    std::string::size_type position;
+    bool failed;
+};
+
+/* the checkpoints of the search for one number */
+class search_checkpoint
+{
+public:
+    /* the checkpoints are written to file, if resume is set the search is
+     * continued from the checkpoint in file (if there is one) */
+    search_checkpoint(const std::string &file, bool resume);
+    ~search_checkpoint();
+
+    /* this function returns true if the checkpoint in file was written by the
+     * algorithm kind for n, the base and steps it used are stored in base and
+     * steps then (see --auto-base) */
+    bool find(const char *kind, const mpz_class &n, mpz_class &base, digit_counter &steps) const;
+
+    /* this function starts the checkpoints of the search of n by the
+     * algorithm kind with base and steps. it returns true and stores the
+     * state which save got last in state if the search is resumed. a
+     * checkpoint of another search is reported and kept, no checkpoints are
+     * written then. */
+    bool start(const char *kind, const mpz_class &n, const mpz_class &base, const digit_counter &steps, std::string &state);
+
+    /* this function returns true (for one caller) if a checkpoint should be
+     * written now */
+    bool due()
+    {
+        return checkpoint_flag.load(std::memory_order_relaxed) && checkpoint_flag.exchange(false);
+    }
+
+    /* this function writes the checkpoint with the state of the algorithm,
+     * it exits the program if a signal requested it */
+    void save(const checkpoint_writer &state);
+
+    /* this function has to be called when the search is complete, the
+     * checkpoint is not needed anymore then and removed */
+    void finish();
+
+    /* this function reports that the state of a resumed search can't be
+     * used (because of reason), the search starts from the beginning then */
+    void reject(const char *reason);
+
+private:
+    std::string file;
+    std::mutex lock;
+
+    /* the checkpoint which was read from file */
+    bool loaded;
+    std::string loaded_kind;
+    mpz_class loaded_n;
+    mpz_class loaded_base;
+    digit_counter loaded_steps;
+    std::string loaded_state;
+
+    /* the search whose checkpoints are written */
+    bool started;
+    std::string kind;
+    mpz_class n;
+    mpz_class base;
+    digit_counter steps;
+};
+
+/* this function returns true if the search of n by the algorithm kind is
+ * resumed from the checkpoint of options (if any) with a base up to max_base
+ * and stores the base and steps it used in base and steps, --auto-base
+ * doesn't choose them again then */
+template<typename number> bool resumed_base(const factorise_options &options, const char *kind, const number &n, const number &max_base, number &base, digit_counter &steps)
+{
+    mpz_class resumed;
+
+    if(options.checkpoint == NULL || !options.checkpoint->find(kind, to_mpz(n), resumed, steps) || resumed > to_mpz(max_base))
+    {
+        return false;
+    }
+
+    base = from_mpz<number>(resumed);
+
+    return true;
+}
+
+#endif /* __CHECKPOINT_H__ */
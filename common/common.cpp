@@ -17,28 +17,202 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <getopt.h>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "cancellation.h"
+#include "checkpoint.h"
 #include "common.h"
+#include "engine.h"
+#include "factor_cache.h"
+#include "full_factorisation.h"
+#include "search_stats.h"
+#include "thread_pool.h"
 
 using namespace std;
 
-/* this function returns true if n is prime and false otherwise
- * this function is only intended for small n */
-bool is_prime(const number &n)
+/* this function returns x * y mod m */
+static inline uint64_t mul_mod(const uint64_t &x, const uint64_t &y, const uint64_t &m)
+{
+    return static_cast<uint64_t>(static_cast<uint128>(x) * y % m);
+}
+
+/* this function returns true if the odd n > a is a strong probable prime to
+ * base a */
+static bool strong_probable_prime(const uint64_t &n, const uint64_t &a)
 {
-    if(n == 2) return true;
-    if(n % 2 == 0) return false;
-    if(n == 1) return false;
+    uint64_t d = n - 1;
+    unsigned int s = 0;
+    uint64_t x = 1;
+    uint64_t y = a;
 
-    for(number i = 3;i <= sqrt(n);i+=2)
+    while(d % 2 == 0)
     {
-        if(n % i == 0) return false;
+        d /= 2;
+        s++;
     }
 
-    return true;
+    for(uint64_t e = d;e > 0;e /= 2)
+    {
+        if(e & 1) x = mul_mod(x, y, n);
+        y = mul_mod(y, y, n);
+    }
+
+    if(x == 1 || x == n - 1) return true;
+
+    for(unsigned int r = 1;r < s;r++)
+    {
+        x = mul_mod(x, x, n);
+        if(x == n - 1) return true;
+    }
+
+    return false;
+}
+
+/* this function returns true if the odd n > 37 is a strong probable prime to
+ * base 2 (miller-rabin) */
+static bool strong_probable_prime(const mpz_class &n)
+{
+    mpz_class d = n - 1;
+    mpz_class x;
+    mp_bitcnt_t s = mpz_scan1(d.get_mpz_t(), 0);
+
+    mpz_tdiv_q_2exp(d.get_mpz_t(), d.get_mpz_t(), s);
+    x = 2;
+    mpz_powm(x.get_mpz_t(), x.get_mpz_t(), d.get_mpz_t(), n.get_mpz_t());
+
+    if(x == 1 || x == n - 1) return true;
+
+    for(mp_bitcnt_t r = 1;r < s;r++)
+    {
+        x = x * x % n;
+        if(x == n - 1) return true;
+    }
+
+    return false;
+}
+
+/* this function returns (x / 2) mod n for 0 <= x < 2n */
+static inline mpz_class half_mod(mpz_class x, const mpz_class &n)
+{
+    if(mpz_odd_p(x.get_mpz_t())) x += n;
+    x /= 2;
+    return x % n;
+}
+
+/* this function returns true if the odd n > 37 is a strong lucas probable
+ * prime with the parameters of selfridge's method a */
+static bool strong_lucas_probable_prime(const mpz_class &n)
+{
+    long d = 5;
+    mpz_class m;
+
+    /* a square never has jacobi(d, n) = -1 */
+    if(mpz_perfect_square_p(n.get_mpz_t())) return false;
+
+    for(;;)
+    {
+        m = d;
+        int j = mpz_jacobi(m.get_mpz_t(), n.get_mpz_t());
+
+        if(j == -1) break;
+        if(j == 0 && abs(d) != n) return false;
+
+        d = (d > 0) ? -(d + 2) : -(d - 2);
+    }
+
+    /* p = 1, q = (1 - d) / 4 */
+    mpz_class q = (1 - d) / 4;
+    mpz_class dm = d;
+    mpz_class k = n + 1;
+    mp_bitcnt_t s = mpz_scan1(k.get_mpz_t(), 0);
+
+    mpz_tdiv_q_2exp(k.get_mpz_t(), k.get_mpz_t(), s);
+    q %= n;
+    if(q < 0) q += n;
+    dm %= n;
+    if(dm < 0) dm += n;
+
+    /* u_1, v_1, q^1 */
+    mpz_class u = 1;
+    mpz_class v = 1;
+    mpz_class qk = q;
+
+    for(long i = static_cast<long>(mpz_sizeinbase(k.get_mpz_t(), 2)) - 2;i >= 0;i--)
+    {
+        /* u_2k = u_k v_k, v_2k = v_k^2 - 2 q^k */
+        u = u * v % n;
+        v = (v * v - 2 * qk) % n;
+        if(v < 0) v += n;
+        qk = qk * qk % n;
+
+        if(mpz_tstbit(k.get_mpz_t(), i))
+        {
+            /* u_k+1 = (p u_k + v_k) / 2, v_k+1 = (d u_k + p v_k) / 2 */
+            mpz_class t = u;
+            u = half_mod(u + v, n);
+            v = half_mod((dm * t % n) + v, n);
+            qk = qk * q % n;
+        }
+    }
+
+    if(u == 0 || v == 0) return true;
+
+    for(mp_bitcnt_t r = 1;r < s;r++)
+    {
+        v = (v * v - 2 * qk) % n;
+        if(v < 0) v += n;
+        if(v == 0) return true;
+        qk = qk * qk % n;
+    }
+
+    return false;
 }
 
-#if USE_GMP
-number my_rand(gmp_randstate_t r_state, number a, number b)
+/* this function returns true if n is prime and false otherwise.
+ * n < 2^64 is tested by a miller-rabin test with a set of bases which is known
+ * to be deterministic there, larger n by the baillie-psw test (strong base 2
+ * miller-rabin and strong lucas test) which has no known pseudoprimes. */
+template<typename number> bool is_prime(const number &n)
+{
+    static const unsigned int small_primes[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+
+    if(n < 2) return false;
+
+    for(unsigned int i = 0;i < sizeof(small_primes) / sizeof(small_primes[0]);i++)
+    {
+        if(n == small_primes[i]) return true;
+        if(n % small_primes[i] == 0) return false;
+    }
+
+    if(bit_length(n) <= 64)
+    {
+        uint64_t m = from_mpz<uint64_t>(to_mpz(n));
+
+        for(unsigned int i = 0;i < sizeof(small_primes) / sizeof(small_primes[0]);i++)
+        {
+            if(!strong_probable_prime(m, small_primes[i])) return false;
+        }
+
+        return true;
+    }
+
+    mpz_class m = to_mpz(n);
+
+    return strong_probable_prime(m) && strong_lucas_probable_prime(m);
+}
+
+#define INSTANTIATE_IS_PRIME(number) template bool is_prime<number>(const number &n);
+FOR_EACH_NUMBER_TYPE(INSTANTIATE_IS_PRIME)
+
+mpz_class my_rand(gmp_randstate_t r_state, mpz_class a, mpz_class b)
 {
     mpz_class r;
     mpz_class limit = b + 1 - a;
@@ -49,115 +223,621 @@ number my_rand(gmp_randstate_t r_state, number a, number b)
     mpz_urandomm(r.get_mpz_t(), r_state, limit.get_mpz_t());
     return r + a;
 }
-#endif
 
-void usage(char *name, bool prime_base, bool trial_division, bool use_steps)
+void usage(char *name, const factorisation_engine &engine)
 {
     cout << "usage:" << endl;
-    if(trial_division)
+    if(engine.trial_division)
     {
-        cout << name << " number" << endl;
+        cout << name << " [options] number" << endl;
         cout << "\tnumber\tis the number which shall be factorised." << endl;
     }
-    else if(use_steps)
+    else if(engine.use_steps)
     {
-        cout << name << " [base [steps]] number" << endl;
+        cout << name << " [options] [base [steps]] number" << endl;
         cout << "\tbase\tIs the base with which the algorithm should calculate, if not" << endl;
         cout << "\t\tspecified base = 2 will be used." << endl;
         cout << "\tnumber\tIs the number which shall be factorised." << endl;
         cout << "\tsteps\tIs the number of iterations for the digit determination which" << endl;
         cout << "\t\tshould be done, if not specified steps = 1 will be used." << endl;
-        cout << "base must be greater than or equal to 2." << endl;
+        cout << "base must be greater than or equal to 2 and less than 2^32." << endl;
         cout << "steps must be positive." << endl;
     }
     else
     {
-        cout << name << " [base] number" << endl;
+        cout << name << " [options] [base] number" << endl;
         cout << "\tbase\tis the base with which the algorithm should calculate, if not" << endl;
         cout << "\t\tspecified base = 2 will be used." << endl;
         cout << "\tnumber\tis the number which shall be factorised." << endl;
-        cout << "base must be greater than or equal to 2." << endl;
+        cout << "base must be greater than or equal to 2 and less than 2^32." << endl;
     }
     cout << "number must be positive." << endl;
 
-    if(prime_base)
+    if(engine.prime_base)
     {
         cout << "base must be prime." << endl;
     }
+
+    cout << "options:" << endl;
+    cout << "\t-j, --threads threads" << endl;
+    cout << "\t\tIs the number of threads which should be used, 0 means one per" << endl;
+    cout << "\t\thardware thread. If not specified threads = 1 will be used." << endl;
+    cout << "\t--processes count" << endl;
+    cout << "\t\tSplits the range of the trial divisions into shards which count" << endl;
+    cout << "\t\tworker processes search, the shards of a worker which dies are" << endl;
+    cout << "\t\tsearched by the others. Not with --input or --checkpoint." << endl;
+    cout << "\t--number-type type" << endl;
+    cout << "\t\tForces the number type used for the calculation (uint64, uint128," << endl;
+    cout << "\t\tuint256 or gmp). If not specified the smallest one which can hold" << endl;
+    cout << "\t\tall intermediate results will be used." << endl;
+
+    cout << "\t-i, --input file" << endl;
+    cout << "\t\tFactorises the numbers in file (one per line, - is the standard" << endl;
+    cout << "\t\tinput) instead of number. The numbers are distributed over the" << endl;
+    cout << "\t\tthreads and every result is written in one line." << endl;
+    cout << "\t--unordered" << endl;
+    cout << "\t\tWrites the results of --input as soon as they are known, prefixed" << endl;
+    cout << "\t\tby the line number, instead of in input order." << endl;
+    cout << "\t--full" << endl;
+    cout << "\t\tCalculates the complete prime factorisation. Small primes are" << endl;
+    cout << "\t\tdivided out by trial division, perfect powers are detected and the" << endl;
+    cout << "\t\tcomposite cofactors are split with pollard's rho, the elliptic" << endl;
+    cout << "\t\tcurve method and finally with this algorithm." << endl;
+    cout << "\t--stats[=json]" << endl;
+    cout << "\t\tWrites statistics of the search tree per depth to the standard" << endl;
+    cout << "\t\terror as a table or as json (needs a build with make STATS=1)." << endl;
+    if(!engine.trial_division)
+    {
+        cout << "\t--auto-base" << endl;
+        cout << "\t\tChooses the base" << (engine.use_steps ? " and steps" : "") << " for every number by estimating the run time" << endl;
+        cout << "\t\tof a few candidates on it, no base" << (engine.use_steps ? " and steps" : "") << " may be given then." << endl;
+    }
+    cout << "\t--checkpoint file" << endl;
+    cout << "\t\tWrites the progress of the search to file every " << CHECKPOINT_INTERVAL << " seconds and" << endl;
+    cout << "\t\twhen the program is interrupted (SIGINT or SIGTERM), the file is" << endl;
+    cout << "\t\tremoved when the search is complete. Not with --input or --full," << endl;
+    cout << "\t\tonly the trial divisions and the digit-by-digit searches write" << endl;
+    cout << "\t\tcheckpoints." << endl;
+    cout << "\t--resume" << endl;
+    cout << "\t\tContinues the search from the file of --checkpoint." << endl;
+    cout << "\t--time-budget seconds" << endl;
+    cout << "\t--node-budget nodes" << endl;
+    cout << "\t\tStops the search of a number after seconds seconds or nodes nodes" << endl;
+    cout << "\t\t(search tree nodes, candidates of the trial divisions, curves or" << endl;
+    cout << "\t\titerations), the number is reported as unknown then together with" << endl;
+    cout << "\t\tthe progress of the search. Not with --full, --checkpoint or" << endl;
+    cout << "\t\t--processes." << endl;
+    cout << "\t--progress seconds" << endl;
+    cout << "\t\tWrites the progress of the search to the standard error every" << endl;
+    cout << "\t\tseconds seconds, every " << PROGRESS_INTERVAL << " seconds if a budget is given." << endl;
+    cout << "\t--cache file" << endl;
+    cout << "\t\tLooks the numbers up in the cache in file (which is created if it" << endl;
+    cout << "\t\tdoesn't exist) before factorising them and adds the results to it." << endl;
+    cout << "\t\tIt keeps the smallest prime factors (found by the trial divisions" << endl;
+    cout << "\t\tor --full) and the probable primes, so all programs may use the" << endl;
+    cout << "\t\tsame file, also at the same time." << endl;
+    cout << "\t--budget stage=value" << endl;
+    cout << "\t\tLimits a stage of --full: trial (primes below value are tried," << endl;
+    cout << "\t\tdefault 65536), rho (steps per cofactor, default 2^20) or ecm" << endl;
+    cout << "\t\t(curves per cofactor, default 500). 0 skips rho or ecm." << endl;
+
+    if(engine.parameters_help != NULL)
+    {
+        cout << "\t-o, --option name=value" << endl;
+        cout << "\t\tSets an algorithm specific parameter:" << endl;
+        cout << engine.parameters_help;
+    }
 }
 
-int common_main(int argc, char *argv[], bool prime_base, bool trial_division, bool use_steps)
+/* the budgets of the search of every number, see cancellation.h */
+struct search_budget
 {
-    number n;
-    number base;
-    digit_counter steps = 1;
-    pair<number, number> factors;
+    search_budget() : seconds(0), nodes(0), progress(0) {}
 
-    if(argc != 2 && (argc != 3 || trial_division) && (argc != 4 || !use_steps))
+    /* this function returns true if the search needs a cancellation token */
+    bool active() const
     {
-        usage(argv[0], prime_base, trial_division, use_steps);
-        return -1;
+        return seconds > 0 || nodes > 0 || progress > 0;
     }
 
-    if(argc == 2)
+    double seconds;
+    uint64_t nodes;
+    /* the seconds between two progress lines, 0 if there are none */
+    double progress;
+};
+
+/* this function writes the prime factorisation of n to out, in one line if
+ * one_line is set */
+static void print_full_factorisation(ostream &out, bool one_line, const mpz_class &n, const vector<pair<mpz_class, unsigned long int>> &factors)
+{
+    if(factors.empty())
     {
-        base = 2;
-#if USE_GMP
-        n = argv[1];
-#else
-        n = strtoull(argv[1], NULL, 10);
-#endif
+        out << (one_line ? "" : "n = ") << n << (one_line ? " has no prime factors\n" : " has no prime factors.\n");
     }
-    else if(argc == 4)
+    else if(factors.size() == 1 && factors[0].second == 1)
     {
-#if USE_GMP
-        base = argv[1];
-        steps = strtoull(argv[2], NULL, 10);
-        n = argv[3];
-#else
-        base = strtoull(argv[1], NULL, 10);
-        steps = strtoull(argv[2], NULL, 10);
-        n = strtoull(argv[3], NULL, 10);
-#endif
+        out << (one_line ? "" : "n = ") << n << (one_line ? " is prime\n" : " is prime.\n");
+    }
+    else
+    {
+        out << (one_line ? "" : "n = ") << n << (one_line ? " = " : " has the prime factorisation:\n");
+
+        for(vector<pair<mpz_class, unsigned long int>>::size_type i = 0;i < factors.size();i++)
+        {
+            out << ((i > 0) ? " * " : "") << factors[i].first;
+            if(factors[i].second > 1) out << "^" << factors[i].second;
+        }
+
+        out << "\n";
+    }
+}
+
+/* this function returns true if type is the name of a number type */
+static bool valid_number_type(const char *type)
+{
+    return strcmp(type, "uint64") == 0 || strcmp(type, "uint128") == 0 || strcmp(type, "uint256") == 0 || strcmp(type, "gmp") == 0;
+}
+
+/* this function runs the algorithm for n with the number type number_type
+ * (NULL picks the smallest one which is large enough) and writes the result
+ * to out (in one line if one_line is set). if budget is not NULL the complete
+ * prime factorisation is calculated, the algorithm only splits what the
+ * cheaper stages left over. the search is stopped when a budget of limits
+ * runs out, n is unknown then and false is returned. */
+static bool factorise_number(const factorisation_engine &engine, ostream &out, bool one_line, const mpz_class &n, const mpz_class &base, const digit_counter &steps, const factorise_options &options, const char *number_type, const factorisation_budget *budget, const search_budget &limits)
+{
+    if(budget != NULL)
+    {
+        vector<pair<mpz_class, unsigned long int>> factors = full_factorisation(n, *budget, options.threads, [&](const mpz_class &c)
+        {
+            return engine.factorise_number(c, base, steps, options, number_type).first;
+        });
+
+        /* the smallest prime factor is known now, whatever the algorithm is */
+        if(options.cache != NULL && !factors.empty())
+        {
+            bool prime = (factors.size() == 1 && factors[0].second == 1);
+
+            options.cache->store(n, prime ? mpz_class(1) : factors[0].first, prime ? n : mpz_class(n / factors[0].first));
+        }
+
+        print_full_factorisation(out, one_line, n, factors);
+
+        return true;
+    }
+
+    pair<mpz_class, mpz_class> factors;
+
+    if(limits.active())
+    {
+        cancellation_token token(n, limits.seconds, limits.nodes, limits.progress);
+        factorise_options limited = options;
+
+        limited.token = &token;
+        factors = engine.factorise_number(n, base, steps, limited, number_type);
+
+        /* a trivial factorisation only means that n is prime if the search
+         * was complete */
+        if((factors.first == 1 || factors.second == 1) && token.cancelled())
+        {
+            out << (one_line ? "" : "n = ") << n << (one_line ? " is unknown (" : " is unknown, the budget ran out after ") << token.progress() << (one_line ? ")\n" : ".\n");
+            return false;
+        }
+    }
+    else
+    {
+        factors = engine.factorise_number(n, base, steps, options, number_type);
+    }
+
+    if((factors.first == 1 || factors.second == 1) && !(factors.first == factors.second))
+    {
+        out << (one_line ? "" : "n = ") << n << (one_line ? " is prime\n" : " is prime.\n");
+    }
+    else if(one_line)
+    {
+        out << n << " = " << factors.first << " * " << factors.second << "\n";
+    }
+    else
+    {
+        out << "n = " << n << " can be factorised as:\n";
+        out << factors.first << " * " << factors.second << "\n";
+    }
+
+    return true;
+}
+
+/* the results of the batch mode are collected in a buffer which is written
+ * to cout in large blocks */
+#define BATCH_OUTPUT_BUFFER 65536
+
+/* this function factorises the numbers in input (one per line) on a pool of
+ * options.threads threads, each number using one thread. the results are
+ * written in one line each, in input order or, if unordered is set, as soon
+ * as they are known prefixed by the line number. at most 64 lines per
+ * thread are read ahead of the oldest unwritten result. */
+static int run_batch(const factorisation_engine &engine, istream &input, bool unordered, const mpz_class &base, const digit_counter &steps, factorise_options options, const char *number_type, const factorisation_budget *budget, const search_budget &limits)
+{
+    struct job
+    {
+        size_t sequence;
+        size_t line;
+        string text;
+    };
+
+    unsigned int threads = worker_count(options.threads);
+    size_t window = 64 * threads;
+    mutex lock;
+    condition_variable work_available, space_available;
+    deque<job> jobs;
+    /* results which are waiting for the ones of earlier lines */
+    map<size_t, string> finished;
+    /* the number of results which were written */
+    size_t written = 0;
+    bool end_of_input = false;
+    string output;
+    vector<thread> workers;
+
+    options.threads = 1;
+
+    function<void()> worker = [&]()
+    {
+        for(;;)
+        {
+            job current;
+
+            {
+                unique_lock<mutex> guard(lock);
+                work_available.wait(guard, [&]() { return !jobs.empty() || end_of_input; });
+
+                if(jobs.empty()) return;
+
+                current = jobs.front();
+                jobs.pop_front();
+            }
+
+            ostringstream result;
+            mpz_class n;
+            string::size_type first = current.text.find_first_not_of(" \t\r");
+            string::size_type last = current.text.find_last_not_of(" \t\r");
+            string text = current.text.substr(first, last - first + 1);
+
+            if(unordered)
+            {
+                result << current.line << " ";
+            }
+
+            if(n.set_str(text, 10) != 0 || n < 1)
+            {
+                result << text << " is not a positive number\n";
+            }
+            else
+            {
+                factorise_number(engine, result, true, n, base, steps, options, number_type, budget, limits);
+            }
+
+            unique_lock<mutex> guard(lock);
+
+            finished[current.sequence] = result.str();
+
+            /* write everything which is complete (in order if requested) */
+            while(!finished.empty() && (unordered || finished.begin()->first == written))
+            {
+                output += finished.begin()->second;
+                finished.erase(finished.begin());
+                written++;
+            }
+
+            if(output.size() >= BATCH_OUTPUT_BUFFER)
+            {
+                cout.write(output.data(), output.size());
+                output.clear();
+            }
+
+            space_available.notify_one();
+        }
+    };
+
+    for(unsigned int i = 0;i < threads;i++)
+    {
+        workers.emplace_back(worker);
     }
-    else if(argc == 3)
+
+    string text;
+    size_t sequence = 0;
+
+    for(size_t line = 1;getline(input, text);line++)
     {
-#if USE_GMP
-        base = argv[1];
-        n = argv[2];
+        if(text.find_first_not_of(" \t\r") == string::npos)
+        {
+            continue;
+        }
+
+        unique_lock<mutex> guard(lock);
+        space_available.wait(guard, [&]() { return sequence < written + window; });
+
+        jobs.push_back(job{sequence++, line, text});
+        work_available.notify_one();
+    }
+
+    {
+        lock_guard<mutex> guard(lock);
+        end_of_input = true;
+        work_available.notify_all();
+    }
+
+    for(vector<thread>::size_type i = 0;i < workers.size();i++)
+    {
+        workers[i].join();
+    }
+
+    cout.write(output.data(), output.size());
+    cout.flush();
+
+    return 0;
+}
+
+/* this function sets the budget of stage (given as stage=value) */
+static bool set_budget(factorisation_budget &budget, const char *stage)
+{
+    const char *value = strchr(stage, '=');
+
+    if(value == NULL)
+    {
+        return false;
+    }
+
+    string name(stage, value - stage);
+    uint64_t limit = strtod(value + 1, NULL);
+
+    if(name == "trial")
+    {
+        budget.trial_bound = limit;
+    }
+    else if(name == "rho")
+    {
+        budget.rho_iterations = limit;
+    }
+    else if(name == "ecm")
+    {
+        budget.ecm_curves = limit;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+int common_main(int argc, char *argv[], const factorisation_engine &engine)
+{
+    mpz_class n;
+    mpz_class base;
+    digit_counter steps = 1;
+    factorise_options options;
+    const char *number_type = NULL;
+    bool full = false;
+    factorisation_budget budget;
+    const char *input = NULL;
+    bool unordered = false;
+    bool stats = false;
+    bool stats_json = false;
+    const char *checkpoint_file = NULL;
+    bool resume = false;
+    search_budget limits;
+    bool progress = false;
+    const char *cache_file = NULL;
+    int result;
+    int opt;
+
+    static const struct option long_options[] = {
+        {"threads", required_argument, NULL, 'j'},
+        {"processes", required_argument, NULL, 'P'},
+        {"number-type", required_argument, NULL, 'N'},
+        {"option", required_argument, NULL, 'o'},
+        {"full", no_argument, NULL, 'F'},
+        {"budget", required_argument, NULL, 'B'},
+        {"input", required_argument, NULL, 'i'},
+        {"unordered", no_argument, NULL, 'U'},
+        {"stats", optional_argument, NULL, 'T'},
+        {"auto-base", no_argument, NULL, 'A'},
+        {"checkpoint", required_argument, NULL, 'C'},
+        {"resume", no_argument, NULL, 'R'},
+        {"time-budget", required_argument, NULL, 'S'},
+        {"node-budget", required_argument, NULL, 'K'},
+        {"progress", required_argument, NULL, 'G'},
+        {"cache", required_argument, NULL, 'M'},
+        {NULL, 0, NULL, 0}
+    };
+
+    while((opt = getopt_long(argc, argv, engine.parameters_help != NULL ? "+j:i:o:" : "+j:i:", long_options, NULL)) != -1)
+    {
+        switch(opt)
+        {
+            case 'j':
+                options.threads = strtoul(optarg, NULL, 10);
+                break;
+            case 'P':
+                options.processes = strtoul(optarg, NULL, 10);
+                break;
+            case 'N':
+                number_type = optarg;
+                break;
+            case 'F':
+                full = true;
+                break;
+            case 'i':
+                input = optarg;
+                break;
+            case 'U':
+                unordered = true;
+                break;
+            case 'A':
+                options.auto_base = true;
+                break;
+            case 'C':
+                checkpoint_file = optarg;
+                break;
+            case 'R':
+                resume = true;
+                break;
+            case 'S':
+                limits.seconds = strtod(optarg, NULL);
+                break;
+            case 'K':
+                limits.nodes = strtod(optarg, NULL);
+                break;
+            case 'G':
+                limits.progress = strtod(optarg, NULL);
+                progress = true;
+                break;
+            case 'M':
+                cache_file = optarg;
+                break;
+            case 'T':
+#if SEARCH_STATS
+                if(optarg == NULL || strcmp(optarg, "json") == 0)
+                {
+                    stats = true;
+                    stats_json = (optarg != NULL);
+                    break;
+                }
+                usage(argv[0], engine);
+                return -1;
 #else
-        base = strtoull(argv[1], NULL, 10);
-        n = strtoull(argv[2], NULL, 10);
+                cerr << "the search statistics are not compiled in, rebuild with make STATS=1." << endl;
+                return -1;
 #endif
+            case 'B':
+                if(set_budget(budget, optarg))
+                {
+                    break;
+                }
+                usage(argv[0], engine);
+                return -1;
+            case 'o':
+                if(engine.parameters_help != NULL && strchr(optarg, '=') != NULL)
+                {
+                    const char *value = strchr(optarg, '=');
+                    options.parameters[string(optarg, value - optarg)] = value + 1;
+                    break;
+                }
+                usage(argv[0], engine);
+                return -1;
+            default:
+                usage(argv[0], engine);
+                return -1;
+        }
+    }
+
+    /* only the positional arguments are left */
+    argv[optind - 1] = argv[0];
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    /* in the batch mode the numbers are read from the input instead */
+    int numbers = (input == NULL) ? 1 : 0;
+    int parameters = argc - 1 - numbers;
+
+    if(parameters < 0 || parameters > ((engine.trial_division || options.auto_base) ? 0 : engine.use_steps ? 2 : 1) || (engine.trial_division && options.auto_base))
+    {
+        usage(argv[0], engine);
+        return -1;
     }
 
-    if(base < 2 || n < 1 || steps < 1)
+    /* checkpoints and worker processes are only for the search of a single
+     * number */
+    if((resume && checkpoint_file == NULL) || (checkpoint_file != NULL && (input != NULL || full)) || (options.processes > 0 && (input != NULL || checkpoint_file != NULL)))
     {
-        usage(argv[0], prime_base, trial_division, use_steps);
+        usage(argv[0], engine);
+        return -1;
+    }
+
+    /* the budgets stop the search of a single number in this process, the
+     * stages of --full have their own budgets */
+    if((limits.seconds > 0 || limits.nodes > 0 || progress) && (full || checkpoint_file != NULL || options.processes > 0))
+    {
+        usage(argv[0], engine);
+        return -1;
+    }
+
+    if(!progress && (limits.seconds > 0 || limits.nodes > 0))
+    {
+        limits.progress = PROGRESS_INTERVAL;
+    }
+
+    base = (parameters >= 1) ? mpz_class(argv[1]) : mpz_class(2);
+    steps = (parameters >= 2) ? strtoull(argv[2], NULL, 10) : 1;
+    n = (numbers == 1) ? mpz_class(argv[argc - 1]) : mpz_class(1);
+
+    if(base < 2 || base >= MAX_DIGIT_BASE || n < 1 || steps < 1 || (number_type != NULL && !valid_number_type(number_type)))
+    {
+        usage(argv[0], engine);
         return -3;
     }
 
-    if(prime_base)
+    /* the algorithm chooses a base up to this, the number type is chosen for
+     * the base it picks */
+    if(options.auto_base)
+    {
+        base = engine.use_steps ? MAX_AUTO_WHEEL_BASE : MAX_AUTO_DIGIT_BASE;
+    }
+
+    if(engine.prime_base)
     {
         if(!is_prime(base))
         {
-            usage(argv[0], prime_base, trial_division, use_steps);
+            usage(argv[0], engine);
             return -3;
         }
     }
 
-    factors = factorise(n, base, steps);
+    /* the cache is shared by all numbers (and threads) of this run */
+    unique_ptr<factor_cache> cache(cache_file != NULL ? new factor_cache(cache_file) : NULL);
 
-    if((factors.first == 1 || factors.second == 1) && !(factors.first == factors.second))
+    options.cache = cache.get();
+
+    if(input != NULL && strcmp(input, "-") == 0)
     {
-        cout << "n = " << n << " is prime." << endl;
+        result = run_batch(engine, cin, unordered, base, steps, options, number_type, full ? &budget : NULL, limits);
+    }
+    else if(input != NULL)
+    {
+        ifstream file(input);
+
+        if(!file)
+        {
+            cerr << "cannot open " << input << "." << endl;
+            return -2;
+        }
+
+        result = run_batch(engine, file, unordered, base, steps, options, number_type, full ? &budget : NULL, limits);
+    }
+    else if(checkpoint_file != NULL)
+    {
+        search_checkpoint checkpoint(checkpoint_file, resume);
+
+        options.checkpoint = &checkpoint;
+        factorise_number(engine, cout, false, n, base, steps, options, number_type, NULL, limits);
+        /* the search is complete, its checkpoint isn't needed anymore */
+        checkpoint.finish();
+        cout.flush();
+        result = 0;
     }
     else
     {
-        cout << "n = " << n << " can be factorised as:" << endl;
-        cout << factors.first << " * " << factors.second << endl;
+        bool known = factorise_number(engine, cout, false, n, base, steps, options, number_type, full ? &budget : NULL, limits);
+        cout.flush();
+        result = known ? 0 : -4;
     }
 
-    return 0;
+    if(stats)
+    {
+        /* the statistics of all numbers together in the batch mode */
+        collect_search_stats().print(cerr, stats_json);
+    }
+
+    return result;
 }
 
+
@@ -20,101 +20,209 @@
 #ifndef __COMMON_H__
 #define __COMMON_H__
 
+#include <cstdlib>
 #include <iostream>
+#include <map>
+#include <string>
 #include <tuple>
+#include <vector>
+
+#include "numbers.h"
 
-#if USE_GMP
-#include <gmpxx.h>
-typedef mpz_class number;
-typedef mpf_class float_number;
-typedef unsigned long int digit_counter;
-#else
-typedef unsigned long long int number;
-typedef long double float_number;
 typedef unsigned long int digit_counter;
-#endif
 
-bool is_prime(const number &n);
+/* a single digit, the base has to be smaller than 2^32 so that the product of
+ * two digits fits into a digit */
+typedef unsigned long int digit;
+typedef uint128 wide_digit;
+#define MAX_DIGIT_BASE (1UL << 32)
+
+template<typename number> bool is_prime(const number &n);
 
 /* this function returns true if x is even and false otherwise */
-inline bool is_even(const number &n)
+template<typename number> inline bool is_even(const number &n)
 {
     return (n % 2 == 0);
 }
 
 /* this function returns true if x is odd and false otherwise */
-inline bool is_odd(const number &n)
+template<typename number> inline bool is_odd(const number &n)
 {
     return (n % 2 != 0);
 }
 
-extern std::pair<number, number> factorise(const number &n, const number &base = 2, const digit_counter &steps = 1);
+class search_checkpoint;
+class cancellation_token;
+class factor_cache;
+
+/* options which are passed through from the command line to the algorithms */
+struct factorise_options
+{
+    factorise_options() : threads(1), processes(0), auto_base(false), checkpoint(NULL), token(NULL), cache(NULL) {}
+
+    /* this function returns the algorithm specific parameter name (given as
+     * -o name=value, value may be written like 11e6) or def if it was not given */
+    unsigned long int parameter(const std::string &name, unsigned long int def) const
+    {
+        std::map<std::string, std::string>::const_iterator it = parameters.find(name);
 
-void usage(char *name, bool prime_base);
+        return (it == parameters.end()) ? def : static_cast<unsigned long int>(strtod(it->second.c_str(), NULL));
+    }
 
-int common_main(int argc, char *argv[], bool prime_base, bool trial_division, bool use_steps);
+    /* number of threads the algorithm may use (0 = one per hardware thread) */
+    unsigned int threads;
+    /* number of worker processes the trial divisions spread the search over
+     * (--processes), 0 searches in this process */
+    unsigned int processes;
+    /* the algorithm chooses the base (and steps) for n itself instead of
+     * using the given ones (--auto-base) */
+    bool auto_base;
+    /* the checkpoints of the search (--checkpoint), NULL if there are none,
+     * see checkpoint.h */
+    search_checkpoint *checkpoint;
+    /* the budgets of the search (--time-budget, --node-budget), NULL if
+     * there are none, see cancellation.h */
+    cancellation_token *token;
+    /* the cache of factorisations (--cache), NULL if there is none, see
+     * factor_cache.h */
+    factor_cache *cache;
+    /* algorithm specific parameters by name */
+    std::map<std::string, std::string> parameters;
+};
 
-/* this function returns x^y */
-#if USE_GMP
-inline number my_sqrt(const number &x)
+/* the largest bases which --auto-base chooses for the digit-by-digit
+ * algorithms and for the wheel of enhanced trial division. with auto_base set
+ * the engine chooses a base up to one of these, the number type is chosen for
+ * the base it picks (see factorisation_engine::factorise_uncached). */
+#define MAX_AUTO_DIGIT_BASE 30
+#define MAX_AUTO_WHEEL_BASE 30030
+
+struct factorisation_engine;
+
+void usage(char *name, const factorisation_engine &engine);
+
+/* this function returns the number of bits the digit-by-digit algorithms need
+ * for their intermediate results. a node at depth d > 0 has base^d <= n, so
+ * its current_base base^(d + 1) has at most bit_length(n) + bit_length(base)
+ * bits and its factors so far are smaller. a * b and bound_factors (with
+ * factors below 2 * current_base) stay below (2 * current_base)^2 and the
+ * children get current_base * base. */
+inline unsigned int digit_search_bits(const mpz_class &n, const mpz_class &base, const digit_counter &steps)
+{
+    // not used
+    (void)steps;
+
+    return 2 * (bit_length(n) + bit_length(base)) + 2;
+}
+
+/* this function returns the number of bits the algorithms need which only
+ * divide n by numbers up to (a little above) its square root */
+inline unsigned int square_root_bits(const mpz_class &n, const mpz_class &base, const digit_counter &steps)
+{
+    // not used
+    (void)base;
+    (void)steps;
+
+    return bit_length(n) + 1;
+}
+
+/* this function returns the name of the smallest number type (uint64,
+ * uint128, uint256 or gmp) which holds numbers of bits bits */
+inline const char *smallest_number_type(const unsigned int &bits)
+{
+    return (bits <= 64) ? "uint64" : (bits <= 128) ? "uint128" : (bits <= 256) ? "uint256" : "gmp";
+}
+
+/* this function is the program which factorises with engine (see engine.h) */
+int common_main(int argc, char *argv[], const factorisation_engine &engine);
+
+/* this function returns the integer square root of x */
+template<typename number> inline number my_sqrt(const number &x)
+{
+    if(x < 2) return x;
+
+    /* newton's iteration starting above the root */
+    number r = 1;
+    for(unsigned int i = 0;i < (bit_length(x) + 1) / 2;i++) r *= 2;
+
+    for(;;)
+    {
+        number y = (r + x / r) / 2;
+        if(y >= r) return r;
+        r = y;
+    }
+}
+
+inline mpz_class my_sqrt(const mpz_class &x)
 {
     mpz_class r;
     mpz_sqrt(r.get_mpz_t(), x.get_mpz_t());
     return r;
 }
-inline number my_root(const number &x, const digit_counter &p)
+
+/* this function returns the integer p-th root of x */
+template<typename number> inline number my_root(const number &x, const digit_counter &p)
 {
     mpz_class r;
-    mpz_root(r.get_mpz_t(), x.get_mpz_t(), p);
+    mpz_root(r.get_mpz_t(), to_mpz(x).get_mpz_t(), p);
+    return from_mpz<number>(r);
+}
+
+/* this function returns x^y */
+template<typename number> inline number my_pow(number x, digit_counter y)
+{
+    number r = 1;
+
+    while(y > 0)
+    {
+        if(y & 1) r *= x;
+        y >>= 1;
+        if(y > 0) x *= x;
+    }
+
     return r;
 }
-inline number my_pow(const number &x, const digit_counter &y)
+
+inline mpz_class my_pow(const mpz_class &x, const digit_counter &y)
 {
     mpz_class r;
     mpz_pow_ui(r.get_mpz_t(), x.get_mpz_t(), y);
     return r;
 }
-#else
-#include <cmath>
-#define my_sqrt(...) (number)sqrt(__VA_ARGS__)
-#define my_root(x, p) (number)pow(x, p)
-#define my_pow(...) (number)pow(__VA_ARGS__)
-#endif
 
 /* this function finds the inverse of x modulo mod if it exists */
-inline std::pair<bool, number> find_inverse(const number &x, const number &mod)
+template<typename number> inline std::pair<bool, number> find_inverse(const number &x, const number &mod)
 {
-#if USE_GMP
     mpz_class r;
-    int b = mpz_invert(r.get_mpz_t(), x.get_mpz_t(), mod.get_mpz_t());
+    int b = mpz_invert(r.get_mpz_t(), to_mpz(x).get_mpz_t(), to_mpz(mod).get_mpz_t());
 
-    return ((b != 0) ? std::make_pair(true, r) : std::make_pair(false, static_cast<number>(0)));
-#else
-    for(number k = 1;k < mod;k++)
-    {
-        if((k * x) % mod == 1) return std::make_pair(true, k);
-    }
+    return ((b != 0) ? std::make_pair(true, from_mpz<number>(r)) : std::make_pair(false, static_cast<number>(0)));
+}
 
-    return std::make_pair(false, 0);
-#endif
+/* this function returns the greatest common divisor of x and y */
+inline mpz_class gcd(const mpz_class &x, const mpz_class &y)
+{
+    mpz_class r;
+    mpz_gcd(r.get_mpz_t(), x.get_mpz_t(), y.get_mpz_t());
+    return r;
 }
 
 /* this function sets the left-most digit of x to digit in base base
  * (if the digit corresponding to digit_base of x is zero otherwise garbage) */
-inline void set_digit(number &x, const number &digit, const number &digit_base)
+template<typename number, typename digit_type> inline void set_digit(number &x, const digit_type &digit, const number &digit_base)
 {
     x += digit * digit_base;
 }
 
 /* this function returns the digit_number-th digit of x in base base) */
-inline number get_digit(const number &x, const number &digit_base, const number &base)
+template<typename number> inline number get_digit(const number &x, const number &digit_base, const number &base)
 {
     return (x / digit_base) % base;
 }
 
 /* this function checks if the new digits solve the digit equation for digit number current_digit
  * and returns a pair consisting of the check and the new carry */
-inline std::pair<bool, number> check_if_new_digits_solve_digit_equation(const number &n, const number &first_factor_so_far, const number &second_factor_so_far, const number &carry, const digit_counter &current_digit, const number &base, const number &previous_base)
+template<typename number> inline std::pair<bool, number> check_if_new_digits_solve_digit_equation(const number &n, const number &first_factor_so_far, const number &second_factor_so_far, const number &carry, const digit_counter &current_digit, const number &base, const number &previous_base)
 {
     number tmp = 0;
     number new_carry = 0;
@@ -142,12 +250,59 @@ inline std::pair<bool, number> check_if_new_digits_solve_digit_equation(const nu
     return std::make_pair(false, 0);
 }
 
-#if USE_GMP
-number my_rand(gmp_randstate_t r_state, number a, number b);
-#endif
+/* what bound_factors knows about a subtree of the digit-by-digit search */
+enum factor_bound
+{
+    /* the subtree contains no non trivial factorisation */
+    BOUND_EMPTY,
+    /* the subtree has to be searched */
+    BOUND_OPEN,
+    /* one of the factors can't grow anymore and divides n */
+    BOUND_FACTOR
+};
+
+/* this function bounds the factorisations n = a' * b' below a node with the
+ * digits a and b modulo m (a' = a, b' = b modulo m). either a' = a or
+ * a' >= a + m and the same holds for b', a' = a is no non trivial factor if
+ * a <= 1. so if the smallest non trivial a' and b' already give a product
+ * larger than n the subtree is empty, if (a + m) * (b + m) > n one of the
+ * factors is complete and the subtree is decided by a division. for
+ * BOUND_FACTOR the factor is stored in factor. */
+template<typename number> inline factor_bound bound_factors(const number &n, const number &a, const number &b, const number &m, number &factor)
+{
+    number a_next = a + m;
+    number b_next = b + m;
+
+    if((a > 1 ? a : a_next) * (b > 1 ? b : b_next) > n)
+    {
+        return BOUND_EMPTY;
+    }
+
+    if(a_next * b_next <= n)
+    {
+        return BOUND_OPEN;
+    }
+
+    /* a and b are smaller than n because the other factor is at least 2 */
+    if(a > 1 && n % a == 0)
+    {
+        factor = a;
+        return BOUND_FACTOR;
+    }
+
+    if(b > 1 && n % b == 0)
+    {
+        factor = b;
+        return BOUND_FACTOR;
+    }
+
+    return BOUND_EMPTY;
+}
+
+mpz_class my_rand(gmp_randstate_t r_state, mpz_class a, mpz_class b);
 
 /* this function returns the number of digits of x in base base */
-inline digit_counter num_of_digits(number x, const number &base)
+template<typename number> inline digit_counter num_of_digits(number x, const number &base)
 {
     digit_counter digits = 0;
 
@@ -159,5 +314,230 @@ inline digit_counter num_of_digits(number x, const number &base)
     return digits;
 }
 
+/* this function converts x (which has to be smaller than MAX_DIGIT_BASE) to a digit */
+template<typename number> inline digit to_digit(const number &x)
+{
+    return static_cast<digit>(x);
+}
+
+inline digit to_digit(const uint256 &x)
+{
+    return x.get_limb(0);
+}
+
+inline digit to_digit(const mpz_class &x)
+{
+    return x.get_ui();
+}
+
+/* this function finds the inverse of x modulo mod if it exists */
+inline std::pair<bool, digit> find_digit_inverse(const digit &x, const digit &mod)
+{
+    /* extended euclidean algorithm, the coefficients are kept modulo mod */
+    digit r0 = mod, r1 = x % mod;
+    digit t0 = 0, t1 = 1;
+
+    while(r1 != 0)
+    {
+        digit q = r0 / r1;
+        digit r2 = r0 - q * r1;
+        digit t2 = (t0 + (mod - (q * t1) % mod)) % mod;
+
+        r0 = r1; r1 = r2;
+        t0 = t1; t1 = t2;
+    }
+
+    return ((r0 == 1) ? std::make_pair(true, t0 % mod) : std::make_pair(false, static_cast<digit>(0)));
+}
+
+/* this function returns the greatest common divisor of x and y */
+inline digit digit_gcd(digit x, digit y)
+{
+    while(y != 0)
+    {
+        digit r = x % y;
+        x = y;
+        y = r;
+    }
+
+    return x;
+}
+
+/* the gcd class of a digit x modulo base: g = gcd(x, base) and the inverse of
+ * x / g modulo base / g */
+struct digit_class
+{
+    digit g;
+    digit inverse;
+};
+
+inline digit_class find_digit_class(const digit &x, const digit &base)
+{
+    digit_class c;
+
+    c.g = digit_gcd(x, base);
+    c.inverse = find_digit_inverse(x / c.g, base / c.g).second;
+
+    return c;
+}
+
+/* the classes of all digits are precomputed for bases up to this */
+#define DIGIT_TABLE_LIMIT (1UL << 16)
+
+/* this class solves x * y = target (mod base) for y. with g = gcd(x, base)
+ * there is a solution if and only if g divides target, the solutions are then
+ * y = (target / g) * inverse + k * (base / g) for k = 0..g-1 where inverse is
+ * the inverse of x / g modulo base / g. this works for composite bases as well
+ * as for prime ones (where g is 1 or, for x = 0, base). */
+class digit_solver
+{
+public:
+    explicit digit_solver(const digit &base) : b(base)
+    {
+        if(base <= DIGIT_TABLE_LIMIT)
+        {
+            classes.resize(base);
+
+            for(digit x = 0;x < base;x++)
+            {
+                classes[x] = find_digit_class(x, base);
+            }
+        }
+    }
+
+    digit_class get_class(const digit &x) const
+    {
+        return classes.empty() ? find_digit_class(x, b) : classes[x];
+    }
+
+    /* this function returns the smallest solution y >= lowest for x of the
+     * class c or base if there is none, the other solutions follow in steps of
+     * step(c) */
+    digit first_solution(const digit_class &c, const digit &target, const digit &lowest = 0) const
+    {
+        digit y;
+
+        if(target % c.g != 0)
+        {
+            return b;
+        }
+
+        y = ((target / c.g) * c.inverse) % (b / c.g);
+
+        if(y < lowest)
+        {
+            y += (lowest - y + step(c) - 1) / step(c) * step(c);
+        }
+
+        return y < b ? y : b;
+    }
+
+    digit step(const digit_class &c) const
+    {
+        return b / c.g;
+    }
+
+private:
+    digit b;
+    std::vector<digit_class> classes;
+};
+
+/* the state of the digit-by-digit search: the digits of n and of the two
+ * factors found so far as machine words. the digits of the factors are filled
+ * as the search goes deeper, so the digit equation is a dot product over
+ * machine words instead of bignum divisions. */
+class digit_state
+{
+public:
+    template<typename number> digit_state(number n, const number &base) : b(to_digit(base))
+    {
+        while(n > 0)
+        {
+            number d = n % base;
+            n_digits.push_back(to_digit(d));
+            n /= base;
+        }
+
+        a_digits.resize(n_digits.size() + 1, 0);
+        b_digits.resize(n_digits.size() + 1, 0);
+    }
+
+    /* this function sets the digits 0..digits-1 from the two factors */
+    template<typename number> void load(const digit_counter &digits, number first_factor_so_far, number second_factor_so_far)
+    {
+        for(digit_counter i = 0;i < digits;i++)
+        {
+            number first_factor_digit = first_factor_so_far % b;
+            number second_factor_digit = second_factor_so_far % b;
+
+            set_digits(i, to_digit(first_factor_digit), to_digit(second_factor_digit));
+            first_factor_so_far /= b;
+            second_factor_so_far /= b;
+        }
+    }
+
+    void set_digits(const digit_counter &current_digit, const digit &first_factor_digit, const digit &second_factor_digit)
+    {
+        if(current_digit >= a_digits.size())
+        {
+            a_digits.resize(current_digit + 1, 0);
+            b_digits.resize(current_digit + 1, 0);
+        }
+
+        a_digits[current_digit] = first_factor_digit;
+        b_digits[current_digit] = second_factor_digit;
+    }
+
+    const digit &base() const
+    {
+        return b;
+    }
+
+    digit n_digit(const digit_counter &current_digit) const
+    {
+        return (current_digit < n_digits.size()) ? n_digits[current_digit] : 0;
+    }
+
+    digit first_factor_digit(const digit_counter &current_digit) const
+    {
+        return a_digits[current_digit];
+    }
+
+    /* this function returns the sum over a_i * b_(current_digit - i) for
+     * i = first..current_digit */
+    wide_digit convolution(const digit_counter &current_digit, const digit_counter &first) const
+    {
+        wide_digit tmp = 0;
+
+        for(digit_counter i = first;i <= current_digit;i++)
+        {
+            tmp += static_cast<wide_digit>(a_digits[i] * b_digits[current_digit - i]);
+        }
+
+        return tmp;
+    }
+
+    /* this function checks if the digits set for current_digit solve the digit
+     * equation and stores the new carry in new_carry */
+    bool solves_digit_equation(const digit_counter &current_digit, const digit &carry, digit &new_carry) const
+    {
+        wide_digit tmp = convolution(current_digit, 0) + carry;
+
+        if(static_cast<digit>(tmp % b) == n_digit(current_digit))
+        {
+            new_carry = static_cast<digit>(tmp / b);
+            return true;
+        }
+
+        return false;
+    }
+
+private:
+    digit b;
+    std::vector<digit> n_digits;
+    std::vector<digit> a_digits;
+    std::vector<digit> b_digits;
+};
+
 #endif /* __COMMON_H__ */
 
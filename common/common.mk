@@ -2,20 +2,15 @@ OBJ         := $(patsubst %.c, %.o, $(filter %.c, $(SRC)))
 OBJ         += $(patsubst %.cpp, %.o, $(filter %.cpp, $(SRC)))
 DEP         := $(OBJ:.o=.d)
 
-USE_GMP		?= 1
+CFLAGS      ?= -Wall -Werror -pedantic -std=c99
+CXXFLAGS    ?= -Wall -Werror -pedantic -std=c++11 -pthread
+LDFLAGS     := -pthread
 
-CFLAGS      ?= -Wall -Werror -pedantic -std=c99 -DUSE_GMP=$(USE_GMP)
-CXXFLAGS    ?= -Wall -Werror -pedantic -std=c++11 -DUSE_GMP=$(USE_GMP)
-LDFLAGS     :=
-
-ifeq ($(USE_GMP), 1)
 LDLIBS      := -lgmp -lgmpxx
-else
-LDLIBS		:=
-endif
 
 DEBUG       ?= 0
 VERBOSE     ?= 0
+STATS       ?= 0
 
 ifeq ($(DEBUG),1)
 	CFLAGS += -O0 -g3 -ggdb -pg -DDEBUG=1
@@ -23,6 +18,12 @@ ifeq ($(DEBUG),1)
 	LDFLAGS += -pg
 endif
 
+# compiles in the counters of the search statistics (--stats)
+ifeq ($(STATS),1)
+	CFLAGS += -DSEARCH_STATS=1
+	CXXFLAGS += -DSEARCH_STATS=1
+endif
+
 ifeq ($(VERBOSE),1)
 	MSG := @true
 	CMD :=
@@ -31,7 +32,7 @@ else
 	CMD := @
 endif
 
-.PHONY: release clean
+.PHONY: release clean bench FORCE
 
 release: CFLAGS += -O3 -flto
 release: CXXFLAGS += -O3 -flto
@@ -42,10 +43,32 @@ clean:
 	$(MSG) -e "\tCLEAN\t"
 	$(CMD)$(RM) $(OBJ) $(DEP) $(OUT)
 
-$(OUT): $(OBJ)
+# builds the microbenchmarks of the common primitives and writes their csv to
+# stdout, BENCHFLAGS are passed on (e.g. BENCHFLAGS="--sizes 64,128")
+bench:
+	$(CMD)$(MAKE) --no-print-directory -C ../bench release
+	$(CMD)../bench/microbench $(BENCHFLAGS)
+
+# OUT are programs, static (.a) or shared (.so) libraries. the programs link
+# the libraries in LIBS, those are built by their own makefile.
+$(filter-out %.a %.so, $(OUT)): $(OBJ) $(LIBS)
 	$(MSG) -e "\tLINK\t$@"
 	$(CMD)$(CXX) $(LDFLAGS) -o $@ $^ $(LDLIBS)
 
+$(filter %.a, $(OUT)): $(OBJ)
+	$(MSG) -e "\tAR\t$@"
+	$(CMD)$(RM) $@
+	$(CMD)$(AR) rcs $@ $^
+
+$(filter %.so, $(OUT)): $(OBJ)
+	$(MSG) -e "\tLINK\t$@"
+	$(CMD)$(CXX) $(LDFLAGS) -shared -o $@ $^ $(LDLIBS)
+
+$(LIBS): FORCE
+	$(CMD)$(MAKE) --no-print-directory -C $(dir $@) release
+
+FORCE:
+
 %.o: %.c %.d
 	$(MSG) -e "\tCC\t$@"
 	$(CMD)$(CC) $(CFLAGS) -c $< -o $@
@@ -0,0 +1,355 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+#include "cancellation.h"
+#include "common.h"
+#include "ecm.h"
+#include "prime_sieve.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+/* factors below this are searched by trial division */
+#define TRIAL_DIVISION_LIMIT 1024
+
+/* the distance of the giant steps in stage 2 (2 * 3 * 5 * 7 * 11) */
+#define STAGE2_STEP 2310
+
+const ecm_preset ecm_presets[] = {
+    {15, 2000, 25},
+    {20, 11000, 90},
+    {25, 50000, 300},
+    {30, 250000, 700},
+    {35, 1000000, 1800},
+    {40, 3000000, 5100},
+    {45, 11000000, 10600},
+    {50, 43000000, 19300},
+    {55, 110000000, 49000},
+    {60, 260000000, 124000},
+};
+
+const size_t ecm_preset_count = sizeof(ecm_presets) / sizeof(ecm_presets[0]);
+
+/* a point of a montgomery curve in projective coordinates (X : Z), the y
+ * coordinate is never needed */
+struct point
+{
+    mpz_class x;
+    mpz_class z;
+};
+
+/* the curve b * y^2 = x^3 + a * x^2 + x modulo n given by a24 = (a + 2) / 4 */
+class montgomery_curve
+{
+public:
+    montgomery_curve(const mpz_class &n, const mpz_class &a24) : n(n), a24(a24) {}
+
+    /* r = 2 * p, r may be p */
+    void dbl(point &r, const point &p)
+    {
+        s = p.x + p.z;
+        s = s * s % n;
+        d = p.x - p.z;
+        d = d * d % n;
+        r.x = s * d % n;
+        /* 4 * x * z */
+        s -= d;
+        r.z = s * ((d + a24 * s) % n) % n;
+    }
+
+    /* r = p + q using difference = p - q, r may be p or q */
+    void add(point &r, const point &p, const point &q, const point &difference)
+    {
+        s = (p.x - p.z) * (q.x + q.z) % n;
+        d = (p.x + p.z) * (q.x - q.z) % n;
+        u = s + d;
+        v = s - d;
+        r.x = difference.z * (u * u % n) % n;
+        r.z = difference.x * (v * v % n) % n;
+    }
+
+    /* r = k * p for k >= 1 using the montgomery ladder, r may be p */
+    void multiply(point &r, const point &p, const uint64_t &k)
+    {
+        point r0 = p, r1;
+
+        dbl(r1, p);
+
+        for(int i = bit_length(k) - 2;i >= 0;i--)
+        {
+            if((k >> i) & 1)
+            {
+                add(r0, r1, r0, p);
+                dbl(r1, r1);
+            }
+            else
+            {
+                add(r1, r0, r1, p);
+                dbl(r0, r0);
+            }
+        }
+
+        r = r0;
+    }
+
+    const mpz_class &modulus() const
+    {
+        return n;
+    }
+
+private:
+    mpz_class n;
+    mpz_class a24;
+    /* temporaries */
+    mpz_class s, d, u, v;
+};
+
+/* this function sets up the curve and starting point given by suyama's
+ * parametrisation for sigma (the group order is divisible by 12). it returns
+ * false and stores gcd(n, denominator) in factor if the curve does not exist
+ * modulo n. */
+static bool suyama(const mpz_class &n, const mpz_class &sigma, mpz_class &a24, point &p, mpz_class &factor)
+{
+    mpz_class u = (sigma * sigma - 5) % n;
+    mpz_class v = 4 * sigma % n;
+    mpz_class u3 = u * u * u % n;
+    mpz_class numerator = (v - u) * (v - u) % n * (v - u) % n * (3 * u + v) % n;
+    mpz_class denominator = 16 * u3 * v % n;
+    mpz_class inverse;
+
+    if(mpz_invert(inverse.get_mpz_t(), denominator.get_mpz_t(), n.get_mpz_t()) == 0)
+    {
+        factor = gcd(denominator, n);
+        return false;
+    }
+
+    a24 = numerator * inverse % n;
+    p.x = u3;
+    p.z = v * v * v % n;
+
+    return true;
+}
+
+/* this function runs one curve with the bounds b1 and b2. it returns a
+ * divisor of n which is 1 or n if no factor was found (or the search was
+ * cancelled). if careful is set the gcd is taken after every prime, this
+ * separates the factors if the curve finds all of them at the end of a
+ * stage (which happens if b2 exceeds the factors of a small n). the deadline
+ * of token (if not NULL) is checked every CANCELLATION_POLL_INTERVAL primes
+ * or giant steps, the curve is cancelled when it passed. */
+static mpz_class ecm_curve(const mpz_class &n, const mpz_class &sigma, const unsigned long int &b1, const unsigned long int &b2, const atomic<bool> &found, bool careful, cancellation_token *token)
+{
+    mpz_class a24, g;
+    point q;
+    uint64_t polls = 0;
+
+    if(!suyama(n, sigma, a24, q, g))
+    {
+        return g;
+    }
+
+    montgomery_curve curve(n, a24);
+
+    /* stage 1: multiply by all prime powers <= b1 */
+    prime_sieve primes;
+
+    for(uint64_t p = primes.next();p <= b1;p = primes.next())
+    {
+        uint64_t power = p;
+
+        if(found.load(memory_order_relaxed) || (token != NULL && ++polls % CANCELLATION_POLL_INTERVAL == 0 && token->charge(0))) return 1;
+
+        while(power <= b1 / p) power *= p;
+
+        curve.multiply(q, q, power);
+
+        if(careful && (g = gcd(q.z, n)) != 1)
+        {
+            return g;
+        }
+    }
+
+    g = gcd(q.z, n);
+
+    if(g != 1 || b2 <= b1)
+    {
+        return g;
+    }
+
+    /* stage 2: if the order of q modulo a prime factor of n is p times a b1
+     * smooth number for one prime b1 < p <= b2 then p * q = O modulo this
+     * factor. p is written as m * STAGE2_STEP +- j with j < STAGE2_STEP / 2
+     * and prime to STAGE2_STEP, then m * STAGE2_STEP * q and j * q have the
+     * same x coordinate. the baby steps j * q are computed once and the giant
+     * steps m * STAGE2_STEP * q one after the other. */
+    vector<point> baby(STAGE2_STEP / 2);
+    point q2, giant, current, previous, next;
+
+    curve.dbl(q2, q);
+    baby[1] = q;
+    curve.add(baby[3], q2, q, q);
+
+    for(unsigned int j = 5;j < STAGE2_STEP / 2;j += 2)
+    {
+        curve.add(baby[j], baby[j - 2], q2, baby[j - 4]);
+    }
+
+    curve.multiply(giant, q, STAGE2_STEP);
+
+    mpz_class product = 1;
+    uint64_t m = 0;
+
+    /* baby only holds odd j, so p = 2 is left to stage 1 */
+    primes = prime_sieve(max(b1, 2UL) + 1);
+
+    for(uint64_t p = primes.next();p <= b2;p = primes.next())
+    {
+        uint64_t target = (p + STAGE2_STEP / 2) / STAGE2_STEP;
+        uint64_t j = (p > target * STAGE2_STEP) ? p - target * STAGE2_STEP : target * STAGE2_STEP - p;
+
+        if(target == 0)
+        {
+            /* p = j, so p * q = O means z = 0 */
+            product = product * baby[j].z % n;
+            if(careful && (g = gcd(product, n)) != 1) return g;
+            continue;
+        }
+
+        if(m == 0)
+        {
+            m = target;
+            curve.multiply(current, q, m * STAGE2_STEP);
+            if(m > 1) curve.multiply(previous, q, (m - 1) * STAGE2_STEP);
+        }
+
+        while(m < target)
+        {
+            if(found.load(memory_order_relaxed) || (token != NULL && ++polls % CANCELLATION_POLL_INTERVAL == 0 && token->charge(0))) return 1;
+
+            if(m == 1)
+            {
+                curve.dbl(next, current);
+            }
+            else
+            {
+                curve.add(next, current, giant, previous);
+            }
+
+            previous = current;
+            current = next;
+            m++;
+        }
+
+        product = product * ((current.x * baby[j].z - baby[j].x * current.z) % n) % n;
+
+        if(careful && (g = gcd(product, n)) != 1)
+        {
+            return g;
+        }
+    }
+
+    return gcd(product, n);
+}
+
+mpz_class ecm(const mpz_class &n, const unsigned long int &b1, const unsigned long int &b2, const unsigned long int &curves, const unsigned long int &curve, unsigned int threads, cancellation_token *token)
+{
+    atomic<bool> found(false);
+    mutex result_lock;
+    mpz_class result = 0;
+
+#if DEBUG
+    cout << "running " << curves << " curves with b1 = " << b1 << " and b2 = " << b2 << "." << endl;
+#endif
+
+    run_work_stealing(curves, worker_count(threads), [&](size_t task)
+    {
+        gmp_randstate_t state;
+        mpz_class sigma;
+
+        if(found.load(memory_order_relaxed) || (token != NULL && token->cancelled())) return;
+
+        gmp_randinit_default(state);
+        gmp_randseed_ui(state, curve + task);
+        sigma = my_rand(state, 6, 0xffffffffUL);
+        gmp_randclear(state);
+
+        mpz_class g = ecm_curve(n, sigma, b1, b2, found, false, token);
+
+        /* all factors at once, run the curve again to separate them */
+        if(g == n)
+        {
+            g = ecm_curve(n, sigma, b1, b2, found, true, token);
+        }
+
+        if(token != NULL)
+        {
+            token->charge(1);
+        }
+
+        if(g != 1 && g != n)
+        {
+            lock_guard<mutex> lock(result_lock);
+
+            if(!found.load())
+            {
+#if DEBUG
+                cout << "curve with sigma = " << sigma << " found " << g << "." << endl;
+#endif
+                result = g;
+                found.store(true);
+            }
+        }
+    });
+
+    return result;
+}
+
+mpz_class ecm_factor(const mpz_class &n, size_t level, unsigned long int max_curves, unsigned int threads, unsigned long int curve, cancellation_token *token)
+{
+    mpz_class d = 0;
+
+    /* tiny factors are found faster by trial division, they would also make
+     * suyama's parametrisation fail for many sigma */
+    prime_sieve primes;
+
+    for(uint64_t p = primes.next();p < TRIAL_DIVISION_LIMIT;p = primes.next())
+    {
+        if(n % p == 0)
+        {
+            return p;
+        }
+    }
+
+    for(unsigned long int run = 0;d == 0 && (max_curves == 0 || run < max_curves) && (token == NULL || !token->cancelled());level = min(level + 1, ecm_preset_count - 1))
+    {
+        const ecm_preset &preset = ecm_presets[min(level, ecm_preset_count - 1)];
+        unsigned long int curves = (max_curves == 0) ? preset.curves : min(preset.curves, max_curves - run);
+
+        d = ecm(n, preset.b1, 100 * preset.b1, curves, curve, threads, token);
+        curve += curves;
+        run += curves;
+    }
+
+    return d;
+}
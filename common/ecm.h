@@ -0,0 +1,55 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __ECM_H__
+#define __ECM_H__
+
+#include <cstddef>
+
+#include <gmpxx.h>
+
+/* B1 and the number of curves which find a factor of the given number of
+ * digits with high probability (the curve counts are the ones of gmp-ecm) */
+struct ecm_preset
+{
+    unsigned int digits;
+    unsigned long int b1;
+    unsigned long int curves;
+};
+
+class cancellation_token;
+
+extern const ecm_preset ecm_presets[];
+extern const std::size_t ecm_preset_count;
+
+/* this function runs curves curves of lenstra's elliptic curve method with
+ * the bounds b1 and b2 on threads threads, the first curve which finds a
+ * factor of n cancels all others. curve is the number of the first curve, it
+ * seeds sigma so that no curve is run twice. it returns 0 if no factor was
+ * found. every curve is charged to token (if not NULL), no curves are started
+ * anymore when it is cancelled. */
+mpz_class ecm(const mpz_class &n, const unsigned long int &b1, const unsigned long int &b2, const unsigned long int &curves, const unsigned long int &curve, unsigned int threads, cancellation_token *token = NULL);
+
+/* this function returns a non-trivial factor of the composite n. it runs the
+ * presets starting with ecm_presets[level] (b2 = 100 * b1) and repeats the
+ * last one until a factor is found or max_curves curves were run (0 means no
+ * limit) or token (if not NULL) is cancelled, then it returns 0. */
+mpz_class ecm_factor(const mpz_class &n, std::size_t level, unsigned long int max_curves, unsigned int threads, unsigned long int curve = 0, cancellation_token *token = NULL);
+
+#endif /* __ECM_H__ */
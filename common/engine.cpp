@@ -0,0 +1,186 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <iostream>
+
+#include "cancellation.h"
+#include "engine.h"
+#include "factor_cache.h"
+
+using namespace std;
+
+const factorisation_engine *const engines[] = {
+    &trial_division_engine,
+    &enhanced_trial_division_engine,
+    &first_engine,
+    &second_engine,
+    &third_engine,
+    &pollard_rho_engine,
+    &ecm_engine,
+};
+
+const size_t engine_count = sizeof(engines) / sizeof(engines[0]);
+
+const factorisation_engine *find_engine(const string &name)
+{
+    for(size_t i = 0;i < engine_count;i++)
+    {
+        if(name == engines[i]->name)
+        {
+            return engines[i];
+        }
+    }
+
+    return NULL;
+}
+
+template<typename number> static pair<mpz_class, mpz_class> factorise_as(const factorisation_engine &engine, const mpz_class &n, const mpz_class &base, const digit_counter &steps, const factorise_options &options)
+{
+    pair<number, number> factors = engine.factorise(from_mpz<number>(n), from_mpz<number>(base), steps, options);
+
+    return make_pair(to_mpz(factors.first), to_mpz(factors.second));
+}
+
+/* this function chooses the base (at most base) and steps with choose for
+ * --auto-base, see choose_base_function */
+template<typename number> static bool choose_base_as(choose_base_function<number> choose, const mpz_class &n, mpz_class &base, digit_counter &steps, const factorise_options &options, pair<mpz_class, mpz_class> &factors)
+{
+    number chosen_base;
+    pair<number, number> found;
+
+    if(choose(from_mpz<number>(n), from_mpz<number>(base), chosen_base, steps, options, found))
+    {
+        factors = make_pair(to_mpz(found.first), to_mpz(found.second));
+        return true;
+    }
+
+    base = to_mpz(chosen_base);
+
+    return false;
+}
+
+pair<mpz_class, mpz_class> factorisation_engine::factorise_number(const mpz_class &n, const mpz_class &base, const digit_counter &steps, const factorise_options &options, const char *number_type) const
+{
+    pair<mpz_class, mpz_class> factors;
+
+    if(options.cache != NULL && options.cache->find(n, factors.first, factors.second))
+    {
+        return factors;
+    }
+
+    factors = factorise_uncached(n, base, steps, options, number_type);
+
+    /* a search which ran out of budget neither knows whether n is prime nor
+     * whether its factor is the smallest one */
+    if(options.cache == NULL || (options.token != NULL && options.token->cancelled()))
+    {
+        return factors;
+    }
+
+    if(factors.first == 1 || factors.second == 1)
+    {
+        /* a trivial result may also mean that the algorithm gave up */
+        if(is_prime(n))
+        {
+            options.cache->store(n, 1, n);
+        }
+    }
+    else if(smallest_factor)
+    {
+        /* the cache only holds the smallest prime factor, which every
+         * engine may return */
+        options.cache->store(n, factors.first, factors.second);
+    }
+
+    return factors;
+}
+
+const char *factorisation_engine::smallest_number_type(const mpz_class &n, const mpz_class &base, const digit_counter &steps) const
+{
+    return ::smallest_number_type(required_bits(n, base, steps));
+}
+
+bool factorisation_engine::choose_base(const mpz_class &n, mpz_class &base, digit_counter &steps, const factorise_options &options, pair<mpz_class, mpz_class> &factors, const char *number_type) const
+{
+    /* the probes run with the number type of the largest base */
+    if(number_type == NULL)
+    {
+        number_type = smallest_number_type(n, base, steps);
+    }
+
+    if(strcmp(number_type, "uint64") == 0)
+    {
+        return choose_base_as<uint64_t>(choose_base_uint64, n, base, steps, options, factors);
+    }
+    else if(strcmp(number_type, "uint128") == 0)
+    {
+        return choose_base_as<uint128>(choose_base_uint128, n, base, steps, options, factors);
+    }
+    else if(strcmp(number_type, "uint256") == 0)
+    {
+        return choose_base_as<uint256>(choose_base_uint256, n, base, steps, options, factors);
+    }
+
+    return choose_base_as<mpz_class>(choose_base_gmp, n, base, steps, options, factors);
+}
+
+pair<mpz_class, mpz_class> factorisation_engine::factorise_uncached(const mpz_class &n, const mpz_class &base, const digit_counter &steps, const factorise_options &options, const char *number_type) const
+{
+    if(options.auto_base)
+    {
+        mpz_class chosen_base = base;
+        digit_counter chosen_steps = steps;
+        factorise_options chosen_options = options;
+        pair<mpz_class, mpz_class> factors;
+
+        if(choose_base(n, chosen_base, chosen_steps, options, factors, number_type))
+        {
+            return factors;
+        }
+
+        chosen_options.auto_base = false;
+
+        return factorise_uncached(n, chosen_base, chosen_steps, chosen_options, number_type);
+    }
+
+    if(number_type == NULL)
+    {
+        number_type = smallest_number_type(n, base, steps);
+    }
+
+#if DEBUG
+    cout << "using number type " << number_type << " (" << required_bits(n, base, steps) << " bits needed)." << endl;
+#endif
+
+    if(strcmp(number_type, "uint64") == 0)
+    {
+        return factorise_as<uint64_t>(*this, n, base, steps, options);
+    }
+    else if(strcmp(number_type, "uint128") == 0)
+    {
+        return factorise_as<uint128>(*this, n, base, steps, options);
+    }
+    else if(strcmp(number_type, "uint256") == 0)
+    {
+        return factorise_as<uint256>(*this, n, base, steps, options);
+    }
+
+    return factorise_as<mpz_class>(*this, n, base, steps, options);
+}
@@ -0,0 +1,149 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* the algorithms of libfactor. every algorithm is a factorisation_engine which
+ * its engine.cpp defines with DEFINE_ENGINE, the registry finds them by name
+ * (see engines). the programs are common_main with one engine. */
+
+#ifndef __ENGINE_H__
+#define __ENGINE_H__
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include "common.h"
+
+/* the algorithm for one number type */
+template<typename number> using factorise_function = std::pair<number, number> (*)(const number &n, const number &base, const digit_counter &steps, const factorise_options &options);
+
+/* the choice of the base (at most max_base) and steps for --auto-base for one
+ * number type. it returns true if it factorised n on the way, the factors are
+ * stored in factors then. */
+template<typename number> using choose_base_function = bool (*)(const number &n, const number &max_base, number &base, digit_counter &steps, const factorise_options &options, std::pair<number, number> &factors);
+
+/* the choice of the algorithms which don't use the base, they keep it */
+template<typename number> bool keep_base(const number &n, const number &max_base, number &base, digit_counter &steps, const factorise_options &options, std::pair<number, number> &factors)
+{
+    // not used
+    (void)n;
+    (void)steps;
+    (void)options;
+    (void)factors;
+
+    base = max_base;
+
+    return false;
+}
+
+/* the number of bits the intermediate results of the algorithm need */
+typedef unsigned int (*bits_function)(const mpz_class &n, const mpz_class &base, const digit_counter &steps);
+
+struct factorisation_engine
+{
+    /* the name under which the registry finds the engine */
+    const char *name;
+    /* the bits its intermediate results need, e.g. digit_search_bits */
+    bits_function required_bits;
+    /* the arguments of its command line, see usage */
+    bool prime_base;
+    bool trial_division;
+    bool use_steps;
+    /* the algorithm always returns the smallest prime factor */
+    bool smallest_factor;
+    /* describes the algorithm specific parameters, NULL if there are none */
+    const char *parameters_help;
+
+    factorise_function<uint64_t> factorise_uint64;
+    factorise_function<uint128> factorise_uint128;
+    factorise_function<uint256> factorise_uint256;
+    factorise_function<mpz_class> factorise_gmp;
+
+    choose_base_function<uint64_t> choose_base_uint64;
+    choose_base_function<uint128> choose_base_uint128;
+    choose_base_function<uint256> choose_base_uint256;
+    choose_base_function<mpz_class> choose_base_gmp;
+
+    /* this function runs the algorithm with the number type number, which
+     * has to hold the intermediate results (see smallest_number_type) */
+    template<typename number> std::pair<number, number> factorise(const number &n, const number &base = 2, const digit_counter &steps = 1, const factorise_options &options = factorise_options()) const;
+
+    /* this function returns the name of the smallest number type which
+     * holds the intermediate results of the algorithm for n */
+    const char *smallest_number_type(const mpz_class &n, const mpz_class &base = 2, const digit_counter &steps = 1) const;
+
+    /* this function runs the algorithm with the number type number_type
+     * (uint64, uint128, uint256 or gmp), NULL picks the smallest one which
+     * is large enough. with options.auto_base the base (at most base) is
+     * chosen first and the number type for it. the factorisation is looked
+     * up in (and added to) options.cache if there is one */
+    std::pair<mpz_class, mpz_class> factorise_number(const mpz_class &n, const mpz_class &base = 2, const digit_counter &steps = 1, const factorise_options &options = factorise_options(), const char *number_type = NULL) const;
+
+    /* the same without the cache */
+    std::pair<mpz_class, mpz_class> factorise_uncached(const mpz_class &n, const mpz_class &base = 2, const digit_counter &steps = 1, const factorise_options &options = factorise_options(), const char *number_type = NULL) const;
+
+    /* this function chooses the base (at most base) and steps of n for
+     * --auto-base, the probes run with the number type number_type (NULL
+     * picks the one of the largest base). it returns true if they factorised
+     * n on the way, the factors are stored in factors then. */
+    bool choose_base(const mpz_class &n, mpz_class &base, digit_counter &steps, const factorise_options &options, std::pair<mpz_class, mpz_class> &factors, const char *number_type = NULL) const;
+};
+
+template<> inline std::pair<uint64_t, uint64_t> factorisation_engine::factorise<uint64_t>(const uint64_t &n, const uint64_t &base, const digit_counter &steps, const factorise_options &options) const
+{
+    return factorise_uint64(n, base, steps, options);
+}
+
+template<> inline std::pair<uint128, uint128> factorisation_engine::factorise<uint128>(const uint128 &n, const uint128 &base, const digit_counter &steps, const factorise_options &options) const
+{
+    return factorise_uint128(n, base, steps, options);
+}
+
+template<> inline std::pair<uint256, uint256> factorisation_engine::factorise<uint256>(const uint256 &n, const uint256 &base, const digit_counter &steps, const factorise_options &options) const
+{
+    return factorise_uint256(n, base, steps, options);
+}
+
+template<> inline std::pair<mpz_class, mpz_class> factorisation_engine::factorise<mpz_class>(const mpz_class &n, const mpz_class &base, const digit_counter &steps, const factorise_options &options) const
+{
+    return factorise_gmp(n, base, steps, options);
+}
+
+/* this defines the engine variable for the algorithm function and the choice
+ * of its base choose_base (templates for all number types, see keep_base) */
+#define DEFINE_ENGINE(variable, name, function, choose_base, required_bits, prime_base, trial_division, use_steps, smallest_factor, parameters_help) \
+    const factorisation_engine variable = {name, required_bits, prime_base, trial_division, use_steps, smallest_factor, parameters_help, function<uint64_t>, function<uint128>, function<uint256>, function<mpz_class>, \
+                                           choose_base<uint64_t>, choose_base<uint128>, choose_base<uint256>, choose_base<mpz_class>};
+
+extern const factorisation_engine first_engine;
+extern const factorisation_engine second_engine;
+extern const factorisation_engine third_engine;
+extern const factorisation_engine trial_division_engine;
+extern const factorisation_engine enhanced_trial_division_engine;
+extern const factorisation_engine pollard_rho_engine;
+extern const factorisation_engine ecm_engine;
+
+/* the registry of all engines */
+extern const factorisation_engine *const engines[];
+extern const std::size_t engine_count;
+
+/* this function returns the engine called name, NULL if there is none */
+const factorisation_engine *find_engine(const std::string &name);
+
+#endif /* __ENGINE_H__ */
@@ -0,0 +1,412 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "factor_cache.h"
+
+using namespace std;
+
+/* the files of version 1 may hold any factor */
+#define CACHE_MAGIC "IFCACHE2"
+
+/* the kinds of entries */
+#define CACHE_EMPTY 0
+#define CACHE_FACTOR 1
+#define CACHE_PROBABLE_PRIME 2
+/* an entry which failed its check, n is looked up no further */
+#define CACHE_DROPPED 3
+
+/* a reader tries this often to copy a slot which is being written */
+#define CACHE_READ_ATTEMPTS 4
+
+struct cache_header
+{
+    char magic[8];
+    uint64_t slots;
+    uint64_t slot_size;
+    /* keeps the slots aligned to 64 bytes */
+    uint64_t unused[5];
+};
+
+struct cache_record
+{
+    /* the checksum of everything after it */
+    uint64_t check;
+    uint8_t kind;
+    uint8_t key_length;
+    uint8_t factor_length;
+    uint8_t unused[5];
+    unsigned char key[CACHE_NUMBER_BYTES];
+    unsigned char factor[CACHE_NUMBER_BYTES];
+};
+
+struct cache_slot
+{
+    /* odd while the record is written */
+    atomic<uint32_t> sequence;
+    uint32_t unused;
+    cache_record record;
+};
+
+static_assert(sizeof(atomic<uint32_t>) == sizeof(uint32_t), "the sequence numbers have to be plain integers in the file");
+
+/* this function returns the fnv-1a hash of size bytes at data */
+static uint64_t fnv1a(const void *data, size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    uint64_t hash = 14695981039346656037ULL;
+
+    for(size_t i = 0;i < size;i++)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+static uint64_t record_check(const cache_record &record)
+{
+    return fnv1a(&record.kind, sizeof(record) - offsetof(cache_record, kind));
+}
+
+/* this function returns the bytes of x, the lowest first */
+static string number_bytes(const mpz_class &x)
+{
+    size_t count = 0;
+    string bytes((mpz_sizeinbase(x.get_mpz_t(), 2) + 7) / 8, '\0');
+
+    mpz_export(&bytes[0], &count, -1, 1, -1, 0, x.get_mpz_t());
+    bytes.resize(count);
+
+    return bytes;
+}
+
+factor_cache::factor_cache(const string &file, uint64_t slots)
+    : file(file), fd(-1), table(NULL), table_size(0), slots(0)
+{
+    cache_header header;
+    struct stat info;
+    bool usable = false;
+
+    fd = open(file.c_str(), O_RDWR | O_CREAT, 0644);
+
+    if(fd >= 0 && flock(fd, LOCK_EX) == 0)
+    {
+        if(fstat(fd, &info) == 0 && info.st_size == 0 && slots > 0)
+        {
+            /* a new file, the zeros of the slots mark them as empty */
+            memset(&header, 0, sizeof(header));
+            memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+            header.slots = slots;
+            header.slot_size = sizeof(cache_slot);
+
+            usable = ftruncate(fd, sizeof(header) + slots * sizeof(cache_slot)) == 0 && pwrite(fd, &header, sizeof(header), 0) == sizeof(header);
+        }
+        else if(fstat(fd, &info) == 0 && pread(fd, &header, sizeof(header), 0) == sizeof(header))
+        {
+            usable = memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) == 0 && header.slot_size == sizeof(cache_slot) && header.slots > 0
+                && static_cast<uint64_t>(info.st_size) >= sizeof(header) + header.slots * sizeof(cache_slot);
+        }
+
+        flock(fd, LOCK_UN);
+    }
+
+    if(usable)
+    {
+        this->slots = header.slots;
+        table_size = sizeof(header) + header.slots * sizeof(cache_slot);
+
+        void *mapping = mmap(NULL, table_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+        table = (mapping == MAP_FAILED) ? NULL : static_cast<unsigned char *>(mapping);
+    }
+
+    if(table == NULL)
+    {
+        cerr << "the cache " << file << " can't be used, the results are only kept in memory." << endl;
+
+        if(fd >= 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+factor_cache::~factor_cache()
+{
+    if(table != NULL)
+    {
+        munmap(table, table_size);
+    }
+
+    if(fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+/* this function returns the slot i of table */
+static inline cache_slot &slot_at(unsigned char *table, uint64_t i)
+{
+    return *reinterpret_cast<cache_slot *>(table + sizeof(cache_header) + i * sizeof(cache_slot));
+}
+
+bool factor_cache::find(const mpz_class &n, mpz_class &first, mpz_class &second)
+{
+    string key = number_bytes(n);
+    entry found;
+    bool known = false;
+
+    {
+        lock_guard<mutex> guard(memory_lock);
+        unordered_map<string, list<pair<string, entry>>::iterator>::iterator it = memory.find(key);
+
+        if(it != memory.end())
+        {
+            recent.splice(recent.begin(), recent, it->second);
+            found = it->second->second;
+            known = true;
+        }
+    }
+
+    if(!known && find_in_file(key, found))
+    {
+        remember(key, found);
+        known = true;
+    }
+
+    if(!known)
+    {
+        return false;
+    }
+
+    /* the entries are checked before they are returned, other processes
+     * write to the file too */
+    if(found.kind == CACHE_PROBABLE_PRIME && is_prime(n))
+    {
+        first = 1;
+        second = n;
+        return true;
+    }
+
+    if(found.kind == CACHE_FACTOR && found.factor >= 2 && found.factor < n && mpz_divisible_p(n.get_mpz_t(), found.factor.get_mpz_t()) != 0)
+    {
+        first = found.factor;
+        second = n / first;
+        return true;
+    }
+
+    forget(key);
+
+    return false;
+}
+
+bool factor_cache::find_in_file(const string &key, entry &found) const
+{
+    if(table == NULL || key.size() > CACHE_NUMBER_BYTES)
+    {
+        return false;
+    }
+
+    uint64_t start = fnv1a(key.data(), key.size()) % slots;
+
+    for(uint64_t i = 0;i < CACHE_PROBES;i++)
+    {
+        const cache_slot &slot = slot_at(table, (start + i) % slots);
+        cache_record copy;
+        bool stable = false;
+
+        for(unsigned int attempt = 0;attempt < CACHE_READ_ATTEMPTS && !stable;attempt++)
+        {
+            uint32_t before = slot.sequence.load(memory_order_acquire);
+
+            if(before & 1)
+            {
+                continue;
+            }
+
+            memcpy(&copy, &slot.record, sizeof(copy));
+            atomic_thread_fence(memory_order_acquire);
+            stable = slot.sequence.load(memory_order_relaxed) == before;
+        }
+
+        if(!stable || copy.check != record_check(copy))
+        {
+            continue;
+        }
+
+        /* n would have been written to this slot */
+        if(copy.kind == CACHE_EMPTY)
+        {
+            return false;
+        }
+
+        if(copy.key_length != key.size() || memcmp(copy.key, key.data(), key.size()) != 0 || copy.factor_length > CACHE_NUMBER_BYTES)
+        {
+            continue;
+        }
+
+        found.kind = copy.kind;
+        found.factor = 0;
+
+        if(copy.kind == CACHE_FACTOR && copy.factor_length > 0)
+        {
+            mpz_import(found.factor.get_mpz_t(), copy.factor_length, -1, 1, -1, 0, copy.factor);
+        }
+
+        return copy.kind == CACHE_FACTOR || copy.kind == CACHE_PROBABLE_PRIME;
+    }
+
+    return false;
+}
+
+void factor_cache::store(const mpz_class &n, const mpz_class &first, const mpz_class &second)
+{
+    entry value;
+
+    if(n < 2)
+    {
+        return;
+    }
+
+    if(first == 1 || second == 1)
+    {
+        value.kind = CACHE_PROBABLE_PRIME;
+        value.factor = 0;
+    }
+    else if(first * second == n)
+    {
+        value.kind = CACHE_FACTOR;
+        value.factor = first;
+    }
+    else
+    {
+        return;
+    }
+
+    string key = number_bytes(n);
+
+    remember(key, value);
+    store_in_file(key, value);
+}
+
+void factor_cache::store_in_file(const string &key, const entry &value)
+{
+    if(table == NULL || key.size() > CACHE_NUMBER_BYTES)
+    {
+        return;
+    }
+
+    cache_record record;
+    string factor = (value.kind == CACHE_FACTOR) ? number_bytes(value.factor) : string();
+
+    memset(&record, 0, sizeof(record));
+    record.kind = value.kind;
+    record.key_length = key.size();
+    record.factor_length = factor.size();
+    memcpy(record.key, key.data(), key.size());
+    memcpy(record.factor, factor.data(), factor.size());
+    record.check = record_check(record);
+
+    lock_guard<mutex> guard(write_lock);
+
+    if(flock(fd, LOCK_EX) != 0)
+    {
+        return;
+    }
+
+    /* the slot of n or the first free one, the one at the hash if all are
+     * taken */
+    uint64_t start = fnv1a(key.data(), key.size()) % slots;
+    cache_slot *target = &slot_at(table, start);
+
+    for(uint64_t i = 0;i < CACHE_PROBES;i++)
+    {
+        cache_slot &slot = slot_at(table, (start + i) % slots);
+
+        if(slot.record.kind == CACHE_EMPTY || (slot.record.key_length == key.size() && memcmp(slot.record.key, key.data(), key.size()) == 0))
+        {
+            target = &slot;
+            break;
+        }
+    }
+
+    /* the sequence number may be odd if a writer died while writing */
+    uint32_t sequence = (target->sequence.load(memory_order_relaxed) + 1) | 1;
+
+    target->sequence.store(sequence, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&target->record, &record, sizeof(record));
+    target->sequence.store(sequence + 1, memory_order_release);
+
+    flock(fd, LOCK_UN);
+}
+
+void factor_cache::remember(const string &key, const entry &value)
+{
+    lock_guard<mutex> guard(memory_lock);
+    unordered_map<string, list<pair<string, entry>>::iterator>::iterator it = memory.find(key);
+
+    if(it != memory.end())
+    {
+        it->second->second = value;
+        recent.splice(recent.begin(), recent, it->second);
+        return;
+    }
+
+    recent.push_front(make_pair(key, value));
+    memory[key] = recent.begin();
+
+    if(recent.size() > CACHE_MEMORY_ENTRIES)
+    {
+        memory.erase(recent.back().first);
+        recent.pop_back();
+    }
+}
+
+void factor_cache::forget(const string &key)
+{
+    entry dropped;
+
+    {
+        lock_guard<mutex> guard(memory_lock);
+        unordered_map<string, list<pair<string, entry>>::iterator>::iterator it = memory.find(key);
+
+        if(it != memory.end())
+        {
+            recent.erase(it->second);
+            memory.erase(it);
+        }
+    }
+
+    /* the slot keeps n, so that the probes of other numbers go on past it
+     * and the next result of n replaces it */
+    dropped.kind = CACHE_DROPPED;
+    store_in_file(key, dropped);
+}
@@ -0,0 +1,107 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* the cache of factorisations (--cache file). the results of the algorithms
+ * are kept in an lru list in memory and in a hash table in file which is
+ * mapped into memory, so that later runs (and other processes at the same
+ * time) find them. the key is n written with mpz_export (the lowest byte
+ * first). an entry holds the smallest prime factor of n, which is a correct
+ * result of every engine, or marks n as a probable prime (proven below 2^64,
+ * the baillie-psw test above, see is_prime).
+ *
+ * the table in file is a header followed by slots, n goes into the first
+ * free slot of the CACHE_PROBES slots from its hash on (or replaces the one
+ * at its hash if all are taken). every slot has a sequence number which is
+ * odd while the slot is written: a reader copies the slot without a lock and
+ * throws the copy away if the sequence number changed meanwhile, writers
+ * lock the file. every slot also has a checksum, and entries are only
+ * returned if n passes is_prime or the factor divides n. */
+
+#ifndef __FACTOR_CACHE_H__
+#define __FACTOR_CACHE_H__
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "common.h"
+
+/* the number of slots of a new file */
+#define CACHE_SLOTS (1UL << 16)
+
+/* the number of slots which are tried for n */
+#define CACHE_PROBES 16
+
+/* the largest n (in bytes) which is written to the file */
+#define CACHE_NUMBER_BYTES 64
+
+/* the number of entries which are kept in memory */
+#define CACHE_MEMORY_ENTRIES 4096
+
+class factor_cache
+{
+public:
+    /* the table is kept in file (with slots slots if it is created), it is
+     * only kept in memory if file can't be used */
+    explicit factor_cache(const std::string &file, uint64_t slots = CACHE_SLOTS);
+    ~factor_cache();
+
+    /* this function returns true if n is in the cache and stores the
+     * factorisation in first and second then, (1, n) if n is a probable
+     * prime */
+    bool find(const mpz_class &n, mpz_class &first, mpz_class &second);
+
+    /* this function adds the factorisation n = first * second to the cache,
+     * first has to be the smallest prime factor of n. a trivial one marks n
+     * as a probable prime */
+    void store(const mpz_class &n, const mpz_class &first, const mpz_class &second);
+
+private:
+    /* the entry of n, kind is CACHE_FACTOR or CACHE_PROBABLE_PRIME */
+    struct entry
+    {
+        uint8_t kind;
+        mpz_class factor;
+    };
+
+    bool find_in_file(const std::string &key, entry &found) const;
+    void store_in_file(const std::string &key, const entry &value);
+    void remember(const std::string &key, const entry &value);
+    void forget(const std::string &key);
+
+    std::string file;
+    int fd;
+    /* the mapping of file, NULL if there is none */
+    unsigned char *table;
+    std::size_t table_size;
+    uint64_t slots;
+    /* the writers of this process, the file lock doesn't separate them */
+    std::mutex write_lock;
+
+    /* the lru list, the most recently used entry first */
+    std::mutex memory_lock;
+    std::list<std::pair<std::string, entry>> recent;
+    std::unordered_map<std::string, std::list<std::pair<std::string, entry>>::iterator> memory;
+};
+
+#endif /* __FACTOR_CACHE_H__ */
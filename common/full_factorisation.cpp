@@ -0,0 +1,172 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "common.h"
+#include "ecm.h"
+#include "full_factorisation.h"
+#include "pollard_rho.h"
+#include "prime_sieve.h"
+
+using namespace std;
+
+/* this function returns r and stores k if n = r^k with the largest possible
+ * k, n has no prime factors below smallest_factor (>= 2) */
+static mpz_class perfect_power(mpz_class n, const uint64_t &smallest_factor, unsigned long int &k)
+{
+    bool found = true;
+
+    k = 1;
+
+    while(found)
+    {
+        /* r >= smallest_factor, so r^e <= n only for small e */
+        unsigned long int max_exponent = (bit_length(n) - 1) / (bit_length(smallest_factor) - 1);
+        prime_sieve exponents;
+
+        found = false;
+
+        for(unsigned long int e = exponents.next();e <= max_exponent && !found;e = exponents.next())
+        {
+            mpz_class r = my_root(n, e);
+
+            if(my_pow(r, e) == n)
+            {
+                n = r;
+                k *= e;
+                found = true;
+            }
+        }
+    }
+
+    return n;
+}
+
+/* this function returns a non-trivial factor of the composite n, the stages
+ * are tried in the order of their cost */
+static mpz_class split(const mpz_class &n, const factorisation_budget &budget, unsigned int threads, const factor_finder &fallback)
+{
+    mpz_class d = 0;
+
+    if(budget.rho_iterations != 0)
+    {
+        d = pollard_rho(n, budget.rho_iterations);
+    }
+
+    if(d == 0 && budget.ecm_curves != 0)
+    {
+#if DEBUG
+        cout << "pollard's rho failed on " << n << ", trying ecm." << endl;
+#endif
+        d = ecm_factor(n, 0, budget.ecm_curves, threads);
+    }
+
+    if(d == 0 && fallback)
+    {
+#if DEBUG
+        cout << "ecm failed on " << n << ", trying the fallback." << endl;
+#endif
+        d = fallback(n);
+    }
+
+    /* the elliptic curve method finds a factor eventually */
+    if(d <= 1 || d >= n)
+    {
+        d = ecm_factor(n, 0, 0, threads);
+    }
+
+    return d;
+}
+
+vector<pair<mpz_class, unsigned long int>> full_factorisation(mpz_class n, const factorisation_budget &budget, unsigned int threads, const factor_finder &fallback)
+{
+    vector<pair<mpz_class, unsigned long int>> factors, result;
+    vector<pair<mpz_class, unsigned long int>> cofactors;
+    prime_sieve primes;
+    uint64_t p;
+
+    /* divide out the small primes, p is the first prime which was not tried */
+    for(p = primes.next();p < budget.trial_bound && n / p >= p;p = primes.next())
+    {
+        if(n % p == 0)
+        {
+            unsigned long int multiplicity = 0;
+
+            while(n % p == 0)
+            {
+                n /= p;
+                multiplicity++;
+            }
+
+            factors.push_back(make_pair(mpz_class(to_mpz(p)), multiplicity));
+        }
+    }
+
+    if(n > 1)
+    {
+        cofactors.push_back(make_pair(n, 1));
+    }
+
+    while(!cofactors.empty())
+    {
+        mpz_class c = cofactors.back().first;
+        unsigned long int multiplicity = cofactors.back().second;
+        unsigned long int k;
+
+        cofactors.pop_back();
+
+        /* after the trial division c < p^2 means that c is prime */
+        if(c / p < p || is_prime(c))
+        {
+            factors.push_back(make_pair(c, multiplicity));
+            continue;
+        }
+
+        mpz_class r = perfect_power(c, p, k);
+
+        if(k > 1)
+        {
+            cofactors.push_back(make_pair(r, k * multiplicity));
+            continue;
+        }
+
+        mpz_class d = split(c, budget, threads, fallback);
+
+        cofactors.push_back(make_pair(d, multiplicity));
+        cofactors.push_back(make_pair(c / d, multiplicity));
+    }
+
+    /* the same prime can come from different cofactors */
+    sort(factors.begin(), factors.end());
+
+    for(vector<pair<mpz_class, unsigned long int>>::size_type i = 0;i < factors.size();i++)
+    {
+        if(!result.empty() && result.back().first == factors[i].first)
+        {
+            result.back().second += factors[i].second;
+        }
+        else
+        {
+            result.push_back(factors[i]);
+        }
+    }
+
+    return result;
+}
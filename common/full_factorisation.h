@@ -0,0 +1,53 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FULL_FACTORISATION_H__
+#define __FULL_FACTORISATION_H__
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <gmpxx.h>
+
+/* the cost budgets of the stages of full_factorisation */
+struct factorisation_budget
+{
+    factorisation_budget() : trial_bound(65536), rho_iterations(1 << 20), ecm_curves(500) {}
+
+    /* primes below this are divided out by trial division */
+    uint64_t trial_bound;
+    /* steps of pollard's rho per cofactor, 0 skips the stage */
+    uint64_t rho_iterations;
+    /* curves of the elliptic curve method per cofactor, 0 skips the stage */
+    unsigned long int ecm_curves;
+};
+
+/* returns a non-trivial factor of the composite n */
+typedef std::function<mpz_class(const mpz_class &)> factor_finder;
+
+/* this function returns the prime factorisation of n > 0 as (prime,
+ * multiplicity) pairs sorted by the primes. small primes are divided out by
+ * trial division, the remaining cofactors are split with pollard's rho, then
+ * the elliptic curve method and finally with fallback (or the elliptic curve
+ * method without a limit if it is empty) until all of them are prime. */
+std::vector<std::pair<mpz_class, unsigned long int>> full_factorisation(mpz_class n, const factorisation_budget &budget, unsigned int threads, const factor_finder &fallback = factor_finder());
+
+#endif /* __FULL_FACTORISATION_H__ */
@@ -0,0 +1,361 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* the number types the algorithms can be compiled for. uint64_t, uint128 and
+ * uint256 are fixed width and wrap around on overflow, mpz_class is unbounded.
+ * common_main picks the smallest one which can hold all intermediate results
+ * for the given input. */
+
+#ifndef __NUMBERS_H__
+#define __NUMBERS_H__
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <algorithm>
+
+#include <gmpxx.h>
+
+__extension__ typedef unsigned __int128 uint128;
+
+/* a 256 bit unsigned integer made of four 64 bit limbs (least significant first) */
+class uint256
+{
+public:
+    uint256(unsigned long long x = 0)
+    {
+        limb[0] = x;
+        limb[1] = limb[2] = limb[3] = 0;
+    }
+
+    uint64_t get_limb(int i) const
+    {
+        return limb[i];
+    }
+
+    void set_limb(int i, uint64_t x)
+    {
+        limb[i] = x;
+    }
+
+    friend bool operator==(const uint256 &x, const uint256 &y)
+    {
+        return x.limb[0] == y.limb[0] && x.limb[1] == y.limb[1] && x.limb[2] == y.limb[2] && x.limb[3] == y.limb[3];
+    }
+
+    friend bool operator<(const uint256 &x, const uint256 &y)
+    {
+        for(int i = 3;i >= 0;i--)
+        {
+            if(x.limb[i] != y.limb[i]) return x.limb[i] < y.limb[i];
+        }
+
+        return false;
+    }
+
+    friend bool operator!=(const uint256 &x, const uint256 &y) { return !(x == y); }
+    friend bool operator>(const uint256 &x, const uint256 &y) { return y < x; }
+    friend bool operator<=(const uint256 &x, const uint256 &y) { return !(y < x); }
+    friend bool operator>=(const uint256 &x, const uint256 &y) { return !(x < y); }
+
+    uint256 &operator+=(const uint256 &y)
+    {
+        uint64_t carry = 0;
+
+        for(int i = 0;i < 4;i++)
+        {
+            uint128 s = static_cast<uint128>(limb[i]) + y.limb[i] + carry;
+            limb[i] = static_cast<uint64_t>(s);
+            carry = static_cast<uint64_t>(s >> 64);
+        }
+
+        return *this;
+    }
+
+    uint256 &operator-=(const uint256 &y)
+    {
+        uint64_t borrow = 0;
+
+        for(int i = 0;i < 4;i++)
+        {
+            uint128 d = static_cast<uint128>(limb[i]) - y.limb[i] - borrow;
+            limb[i] = static_cast<uint64_t>(d);
+            borrow = static_cast<uint64_t>(d >> 64) & 1;
+        }
+
+        return *this;
+    }
+
+    uint256 &operator*=(const uint256 &y)
+    {
+        uint64_t r[4] = {0, 0, 0, 0};
+
+        for(int i = 0;i < 4;i++)
+        {
+            uint64_t carry = 0;
+
+            if(limb[i] == 0) continue;
+
+            for(int j = 0;i + j < 4;j++)
+            {
+                uint128 p = static_cast<uint128>(limb[i]) * y.limb[j] + r[i + j] + carry;
+                r[i + j] = static_cast<uint64_t>(p);
+                carry = static_cast<uint64_t>(p >> 64);
+            }
+        }
+
+        std::copy(r, r + 4, limb);
+
+        return *this;
+    }
+
+    uint256 &operator/=(const uint256 &y)
+    {
+        uint256 q, r;
+        divmod(*this, y, q, r);
+        return *this = q;
+    }
+
+    uint256 &operator%=(const uint256 &y)
+    {
+        uint256 q, r;
+        divmod(*this, y, q, r);
+        return *this = r;
+    }
+
+    uint256 &operator++() { return *this += 1; }
+    uint256 &operator--() { return *this -= 1; }
+    uint256 operator++(int) { uint256 t = *this; *this += 1; return t; }
+    uint256 operator--(int) { uint256 t = *this; *this -= 1; return t; }
+
+    friend uint256 operator+(uint256 x, const uint256 &y) { return x += y; }
+    friend uint256 operator-(uint256 x, const uint256 &y) { return x -= y; }
+    friend uint256 operator*(uint256 x, const uint256 &y) { return x *= y; }
+    friend uint256 operator/(uint256 x, const uint256 &y) { return x /= y; }
+    friend uint256 operator%(uint256 x, const uint256 &y) { return x %= y; }
+
+    /* this function returns the number of significant bits of x */
+    friend unsigned int bit_length(const uint256 &x)
+    {
+        for(int i = 3;i >= 0;i--)
+        {
+            if(x.limb[i] != 0) return 64 * i + 64 - __builtin_clzll(x.limb[i]);
+        }
+
+        return 0;
+    }
+
+    /* this function calculates q = x / y and r = x % y (knuth's algorithm d) */
+    static void divmod(const uint256 &x, const uint256 &y, uint256 &q, uint256 &r)
+    {
+        int m = (bit_length(x) + 63) / 64;
+        int n = (bit_length(y) + 63) / 64;
+
+        q = 0;
+        r = 0;
+
+        if(x < y)
+        {
+            r = x;
+            return;
+        }
+
+        if(n == 1)
+        {
+            uint64_t rest = 0;
+
+            for(int i = m - 1;i >= 0;i--)
+            {
+                uint128 t = (static_cast<uint128>(rest) << 64) | x.limb[i];
+                q.limb[i] = static_cast<uint64_t>(t / y.limb[0]);
+                rest = static_cast<uint64_t>(t % y.limb[0]);
+            }
+
+            r.limb[0] = rest;
+            return;
+        }
+
+        /* normalise so that the top bit of the divisor is set */
+        int s = __builtin_clzll(y.limb[n - 1]);
+        uint64_t vn[4], un[5];
+
+        for(int i = n - 1;i > 0;i--)
+        {
+            vn[i] = (y.limb[i] << s) | (s ? y.limb[i - 1] >> (64 - s) : 0);
+        }
+        vn[0] = y.limb[0] << s;
+
+        un[m] = s ? x.limb[m - 1] >> (64 - s) : 0;
+        for(int i = m - 1;i > 0;i--)
+        {
+            un[i] = (x.limb[i] << s) | (s ? x.limb[i - 1] >> (64 - s) : 0);
+        }
+        un[0] = x.limb[0] << s;
+
+        for(int j = m - n;j >= 0;j--)
+        {
+            uint128 numerator = (static_cast<uint128>(un[j + n]) << 64) | un[j + n - 1];
+            uint128 qhat = numerator / vn[n - 1];
+            uint128 rhat = numerator % vn[n - 1];
+
+            while((qhat >> 64) != 0 || qhat * vn[n - 2] > ((rhat << 64) | un[j + n - 2]))
+            {
+                qhat--;
+                rhat += vn[n - 1];
+                if((rhat >> 64) != 0) break;
+            }
+
+            /* multiply and subtract */
+            uint64_t carry = 0, borrow = 0;
+
+            for(int i = 0;i < n;i++)
+            {
+                uint128 p = qhat * vn[i] + carry;
+                carry = static_cast<uint64_t>(p >> 64);
+                uint128 d = static_cast<uint128>(un[i + j]) - static_cast<uint64_t>(p) - borrow;
+                un[i + j] = static_cast<uint64_t>(d);
+                borrow = static_cast<uint64_t>(d >> 64) & 1;
+            }
+
+            uint128 d = static_cast<uint128>(un[j + n]) - carry - borrow;
+            un[j + n] = static_cast<uint64_t>(d);
+
+            /* qhat was one too large, add the divisor back */
+            if((d >> 64) != 0)
+            {
+                qhat--;
+                carry = 0;
+
+                for(int i = 0;i < n;i++)
+                {
+                    uint128 t = static_cast<uint128>(un[i + j]) + vn[i] + carry;
+                    un[i + j] = static_cast<uint64_t>(t);
+                    carry = static_cast<uint64_t>(t >> 64);
+                }
+
+                un[j + n] += carry;
+            }
+
+            q.limb[j] = static_cast<uint64_t>(qhat);
+        }
+
+        for(int i = 0;i < n;i++)
+        {
+            r.limb[i] = (un[i] >> s) | (s ? un[i + 1] << (64 - s) : 0);
+        }
+    }
+
+private:
+    uint64_t limb[4];
+};
+
+inline unsigned int bit_length(const uint64_t &x)
+{
+    return (x == 0) ? 0 : 64 - __builtin_clzll(x);
+}
+
+inline unsigned int bit_length(const uint128 &x)
+{
+    return ((x >> 64) != 0) ? 64 + bit_length(static_cast<uint64_t>(x >> 64)) : bit_length(static_cast<uint64_t>(x));
+}
+
+inline unsigned int bit_length(const mpz_class &x)
+{
+    return (x == 0) ? 0 : mpz_sizeinbase(x.get_mpz_t(), 2);
+}
+
+/* this function converts the non-negative x to the number type number (x has
+ * to fit into it) */
+template<typename number> inline number from_mpz(const mpz_class &x)
+{
+    number r = 0;
+
+    for(size_t i = mpz_size(x.get_mpz_t());i > 0;i--)
+    {
+        r = r * (static_cast<number>(1) << 32) * (static_cast<number>(1) << 32) + mpz_getlimbn(x.get_mpz_t(), i - 1);
+    }
+
+    return r;
+}
+
+template<> inline uint256 from_mpz<uint256>(const mpz_class &x)
+{
+    uint256 r;
+
+    for(size_t i = 0;i < mpz_size(x.get_mpz_t()) && i < 4;i++)
+    {
+        r.set_limb(i, mpz_getlimbn(x.get_mpz_t(), i));
+    }
+
+    return r;
+}
+
+template<> inline mpz_class from_mpz<mpz_class>(const mpz_class &x)
+{
+    return x;
+}
+
+inline mpz_class to_mpz(const uint64_t &x)
+{
+    mpz_class r;
+    mpz_import(r.get_mpz_t(), 1, -1, sizeof(x), 0, 0, &x);
+    return r;
+}
+
+inline mpz_class to_mpz(const uint128 &x)
+{
+    uint64_t limbs[2] = {static_cast<uint64_t>(x), static_cast<uint64_t>(x >> 64)};
+    mpz_class r;
+    mpz_import(r.get_mpz_t(), 2, -1, sizeof(limbs[0]), 0, 0, limbs);
+    return r;
+}
+
+inline mpz_class to_mpz(const uint256 &x)
+{
+    uint64_t limbs[4] = {x.get_limb(0), x.get_limb(1), x.get_limb(2), x.get_limb(3)};
+    mpz_class r;
+    mpz_import(r.get_mpz_t(), 4, -1, sizeof(limbs[0]), 0, 0, limbs);
+    return r;
+}
+
+inline const mpz_class &to_mpz(const mpz_class &x)
+{
+    return x;
+}
+
+inline std::ostream &operator<<(std::ostream &os, const uint128 &x)
+{
+    return os << to_mpz(x);
+}
+
+inline std::ostream &operator<<(std::ostream &os, const uint256 &x)
+{
+    return os << to_mpz(x);
+}
+
+/* the number of bits a number type can hold, 0 means unbounded */
+template<typename number> struct number_bits { static const unsigned int value = 0; };
+template<> struct number_bits<uint64_t> { static const unsigned int value = 64; };
+template<> struct number_bits<uint128> { static const unsigned int value = 128; };
+template<> struct number_bits<uint256> { static const unsigned int value = 256; };
+
+/* calls X(type) for every number type, smallest first */
+#define FOR_EACH_NUMBER_TYPE(X) X(uint64_t) X(uint128) X(uint256) X(mpz_class)
+
+#endif /* __NUMBERS_H__ */
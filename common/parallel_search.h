@@ -0,0 +1,416 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PARALLEL_SEARCH_H__
+#define __PARALLEL_SEARCH_H__
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "cancellation.h"
+#include "checkpoint.h"
+#include "common.h"
+#include "thread_pool.h"
+
+/* a node of the digit-by-digit search tree, i.e. the arguments with which
+ * find_next_digits is called for it */
+template<typename number> struct search_node
+{
+    search_node(const digit_counter &d, const number &a, const number &b, const number &cb, const number &pb, const digit &c)
+        : current_digit(d), first_factor_so_far(a), second_factor_so_far(b), current_base(cb), previous_base(pb), carry(c) {}
+
+    digit_counter current_digit;
+    number first_factor_so_far;
+    number second_factor_so_far;
+    number current_base;
+    number previous_base;
+    digit carry;
+};
+
+/* the states of checkpoint.h which the digit-by-digit searches write: the
+ * path to the current node of the serial search as the pairs of digits
+ * chosen at every depth, or the subtrees of parallel_digit_search which were
+ * searched completely */
+#define CHECKPOINT_PATH 0
+#define CHECKPOINT_SUBTREES 1
+
+/* the digits of (a, b) which a node chose for its child */
+typedef std::pair<digit, digit> digit_pair;
+
+/* find_next_digits gets a pointer to this (NULL for the plain serial search).
+ * while the frontier is built every node at split_depth is recorded as a
+ * subtree instead of being searched, while a subtree is searched it tells
+ * whether a subtree which comes earlier in the serial order already found a
+ * factorisation so that the search can be abandoned. the serial search with
+ * checkpoints records the path to the current node instead. with a
+ * cancellation token the nodes are counted and charged to it, the search is
+ * abandoned when a budget runs out. */
+template<typename number> class search_control
+{
+public:
+    search_control(const digit_counter &split_depth, std::vector<search_node<number>> *frontier)
+        : split_depth(split_depth), frontier(frontier), found(NULL), task(0), checkpoint(NULL), resuming(false), matched(0), token(NULL), nodes(0), deepest(0) {}
+
+    search_control(const std::atomic<std::size_t> *found, std::size_t task, cancellation_token *token = NULL)
+        : split_depth(0), frontier(NULL), found(found), task(task), checkpoint(NULL), resuming(false), matched(0), token(token), nodes(0), deepest(0) {}
+
+    /* the serial search from the root which writes the path to checkpoint (if
+     * not NULL), it continues after the node at the end of resume_path (if
+     * not empty) */
+    search_control(search_checkpoint *checkpoint, const std::vector<digit_pair> &resume_path, cancellation_token *token = NULL)
+        : split_depth(0), frontier(NULL), found(NULL), task(0), checkpoint(checkpoint), resume_path(resume_path), resuming(!resume_path.empty()), matched(0), token(token), nodes(0), deepest(0) {}
+
+    /* the nodes which weren't charged yet are charged when the search is
+     * done */
+    ~search_control()
+    {
+        if(token != NULL)
+        {
+            token->reach(deepest);
+            token->charge(nodes);
+        }
+    }
+
+    /* this function returns true if the node at depth current_digit shall be
+     * recorded with add_subtree instead of being searched */
+    bool split(const digit_counter &current_digit) const
+    {
+        return frontier != NULL && current_digit >= split_depth;
+    }
+
+    void add_subtree(const search_node<number> &node)
+    {
+        frontier->push_back(node);
+    }
+
+    /* a subtree is also abandoned if the program was interrupted, it is
+     * searched again after --resume */
+    bool cancelled() const
+    {
+        return (found != NULL && (found->load(std::memory_order_relaxed) < task || checkpoint_stop.load(std::memory_order_relaxed))) || (token != NULL && token->cancelled());
+    }
+
+    /* this function is called when the node at depth current_digit is
+     * entered, it writes the path to it if a checkpoint is due. if the node
+     * is the one at which a resumed search continues it returns true and
+     * stores the pair of digits of the child which was searched when the
+     * checkpoint was written, the pairs before it are skipped. */
+    bool enter(const digit_counter &current_digit, digit &first_factor_digit, digit &second_factor_digit)
+    {
+        if(token != NULL)
+        {
+            deepest = std::max(deepest, current_digit);
+
+            if(++nodes == CANCELLATION_POLL_INTERVAL)
+            {
+                token->reach(deepest);
+                token->charge(nodes);
+                nodes = 0;
+            }
+        }
+
+        if(checkpoint == NULL)
+        {
+            return false;
+        }
+
+        if(checkpoint->due())
+        {
+            checkpoint_writer state;
+
+            state.put(static_cast<uint64_t>(CHECKPOINT_PATH));
+            state.put(static_cast<uint64_t>(current_digit));
+
+            for(digit_counter i = 0;i < current_digit;i++)
+            {
+                state.put(static_cast<uint64_t>(path[i].first));
+                state.put(static_cast<uint64_t>(path[i].second));
+            }
+
+            checkpoint->save(state);
+        }
+
+        if(resuming && current_digit == matched && current_digit < resume_path.size())
+        {
+            first_factor_digit = resume_path[current_digit].first;
+            second_factor_digit = resume_path[current_digit].second;
+            return true;
+        }
+
+        /* every node after the end of the resumed path is searched completely */
+        resuming = false;
+
+        return false;
+    }
+
+    /* this function is called before the node at depth current_digit
+     * continues with its child for the given digits */
+    template<typename digit_type> void descend(const digit_counter &current_digit, const digit_type &first_factor_digit, const digit_type &second_factor_digit)
+    {
+        if(checkpoint == NULL)
+        {
+            return;
+        }
+
+        if(current_digit >= path.size())
+        {
+            path.resize(current_digit + 1);
+        }
+
+        path[current_digit] = digit_pair(to_digit(first_factor_digit), to_digit(second_factor_digit));
+
+        if(resuming && current_digit == matched && path[current_digit] == resume_path[current_digit])
+        {
+            matched++;
+        }
+    }
+
+private:
+    digit_counter split_depth;
+    std::vector<search_node<number>> *frontier;
+    const std::atomic<std::size_t> *found;
+    std::size_t task;
+    search_checkpoint *checkpoint;
+    /* the pairs of digits on the path to the current node */
+    std::vector<digit_pair> path;
+    std::vector<digit_pair> resume_path;
+    /* the nodes of resume_path at the depths below matched were entered */
+    bool resuming;
+    digit_counter matched;
+    cancellation_token *token;
+    /* the nodes which were entered since the token was charged last and the
+     * deepest of all of them */
+    uint64_t nodes;
+    digit_counter deepest;
+};
+
+template<typename number> using digit_search = std::function<std::tuple<number, number, bool>(const search_node<number> &, search_control<number> *)>;
+
+/* this function runs search on the tree below root using threads threads.
+ * the tree is cut at the smallest depth which gives enough subtrees, these are
+ * searched by a work-stealing pool in the order of the low digit prefixes of
+ * (a, b). the result of the first subtree (in serial order) containing a
+ * factorisation wins and all later subtrees are cancelled, so the result is
+ * the same as the one of the serial search. with a checkpoint the subtrees
+ * which were searched completely are written after every subtree (if a
+ * checkpoint is due), resume is the state of such a checkpoint after
+ * CHECKPOINT_SUBTREES. the nodes of the subtrees are charged to token (if not
+ * NULL), which also gets the fraction of the subtrees which were searched. */
+template<typename number> inline std::tuple<number, number, bool> parallel_digit_search(const number &n, const number &base, const search_node<number> &root, unsigned int threads, const digit_search<number> &search, search_checkpoint *checkpoint = NULL, checkpoint_reader *resume = NULL, cancellation_token *token = NULL)
+{
+    std::vector<search_node<number>> frontier;
+    std::tuple<number, number, bool> shallow_result;
+    digit_counter max_depth = root.current_digit + num_of_digits(n, base) + 1;
+    digit_counter split_depth = root.current_digit + 1;
+    uint64_t resumed_size = 0;
+    std::string resumed_done;
+
+    threads = worker_count(threads);
+
+    if(resume != NULL)
+    {
+        split_depth = resume->get();
+        resumed_size = resume->get();
+        resumed_done = resume->get_string();
+
+        if(!resume->good() || !resume->at_end() || split_depth <= root.current_digit || split_depth > max_depth)
+        {
+            checkpoint->reject("damaged subtrees");
+            split_depth = root.current_digit + 1;
+            resume = NULL;
+        }
+    }
+
+    /* the subtrees are the children of the root first, every level below
+     * comes from expanding the nodes of the one above, so every node above
+     * split_depth is searched once. a resumed search cuts the tree at the
+     * depth of the checkpoint. */
+    digit_counter target_depth = split_depth;
+    search_control<number> builder(root.current_digit + 1, &frontier);
+
+    split_depth = root.current_digit + 1;
+    /* a factorisation found here comes after all recorded subtrees */
+    shallow_result = search(root, &builder);
+
+    while(!frontier.empty() && split_depth < max_depth && ((resume != NULL) ? split_depth < target_depth : frontier.size() < 8 * threads))
+    {
+        std::vector<search_node<number>> children;
+        search_control<number> expander(split_depth + 1, &children);
+
+        for(typename std::vector<search_node<number>>::size_type i = 0;i < frontier.size();i++)
+        {
+            std::tuple<number, number, bool> result = search(frontier[i], &expander);
+
+            /* it comes before the subtrees of the later nodes, these can't
+             * win anymore */
+            if(std::get<2>(result))
+            {
+                shallow_result = result;
+                break;
+            }
+        }
+
+        frontier.swap(children);
+        split_depth++;
+    }
+
+#if DEBUG
+    std::cout << "searching " << frontier.size() << " subtrees using " << threads << " threads." << std::endl;
+#endif
+
+    std::vector<std::tuple<number, number, bool>> results(frontier.size());
+    std::atomic<std::size_t> found(frontier.size());
+    /* done[task] is set if the subtree was searched completely */
+    std::vector<char> done(frontier.size(), 0);
+    std::mutex done_lock;
+    /* the number of subtrees which were searched completely */
+    std::atomic<std::size_t> searched(0);
+
+    if(resume != NULL && (resumed_size != frontier.size() || resumed_done.size() != (frontier.size() + 7) / 8))
+    {
+        checkpoint->reject("other subtrees");
+    }
+    else if(resume != NULL)
+    {
+        for(std::size_t task = 0;task < frontier.size();task++)
+        {
+            done[task] = (resumed_done[task / 8] >> (task % 8)) & 1;
+        }
+    }
+
+    run_work_stealing(frontier.size(), threads, [&](std::size_t task)
+    {
+        if(found.load(std::memory_order_relaxed) < task || done[task] || (token != NULL && token->cancelled())) return;
+
+        search_control<number> control(&found, task, token);
+        results[task] = search(frontier[task], &control);
+
+        if(token != NULL && !control.cancelled())
+        {
+            token->cover(static_cast<double>(++searched) / frontier.size());
+        }
+
+        if(std::get<2>(results[task]))
+        {
+            std::size_t current = found.load();
+            while(task < current && !found.compare_exchange_weak(current, task));
+        }
+
+        if(checkpoint != NULL)
+        {
+            std::lock_guard<std::mutex> guard(done_lock);
+
+            /* a subtree with a factorisation or which was abandoned is
+             * searched again after a resume */
+            done[task] = !std::get<2>(results[task]) && !control.cancelled();
+
+            if(checkpoint_stop.load() || checkpoint->due())
+            {
+                checkpoint_writer state;
+                std::string bitmap((frontier.size() + 7) / 8, '\0');
+
+                for(std::size_t i = 0;i < frontier.size();i++)
+                {
+                    bitmap[i / 8] |= static_cast<char>(done[i] << (i % 8));
+                }
+
+                state.put(static_cast<uint64_t>(CHECKPOINT_SUBTREES));
+                state.put(static_cast<uint64_t>(split_depth));
+                state.put(static_cast<uint64_t>(frontier.size()));
+                state.put(bitmap);
+                checkpoint->save(state);
+            }
+        }
+    });
+
+    if(found.load() < frontier.size())
+    {
+        return results[found.load()];
+    }
+
+    return shallow_result;
+}
+
+/* this function runs search on the whole tree of n, serially or (if
+ * options.threads != 1) with parallel_digit_search. with --checkpoint the
+ * search writes checkpoints as the algorithm kind and continues from the
+ * one it resumes, with budgets it stops when options.token is cancelled. */
+template<typename number> inline std::tuple<number, number, bool> run_digit_search(const number &n, const number &base, const char *kind, const factorise_options &options, const digit_search<number> &search)
+{
+    search_node<number> root(0, 0, 0, base, 1, 0);
+    std::string state;
+    bool resumed = options.checkpoint != NULL && options.checkpoint->start(kind, to_mpz(n), to_mpz(base), 1, state);
+    checkpoint_reader reader(state);
+    uint64_t mode = resumed ? reader.get() : CHECKPOINT_PATH;
+
+    if(resumed && mode != ((options.threads != 1) ? CHECKPOINT_SUBTREES : CHECKPOINT_PATH))
+    {
+        options.checkpoint->reject((mode == CHECKPOINT_PATH) ? "written by a serial search" : "written by a parallel search");
+        resumed = false;
+    }
+
+    if(options.threads != 1)
+    {
+        return parallel_digit_search<number>(n, base, root, options.threads, search, options.checkpoint, resumed ? &reader : NULL, options.token);
+    }
+
+    if(options.checkpoint == NULL && options.token == NULL)
+    {
+        return search(root, NULL);
+    }
+
+    std::vector<digit_pair> path;
+
+    if(resumed)
+    {
+        uint64_t depth = reader.get();
+        digit digit_base = to_digit(base);
+
+        for(uint64_t i = 0;i < depth && reader.good();i++)
+        {
+            digit first_factor_digit = reader.get();
+            digit second_factor_digit = reader.get();
+
+            path.push_back(digit_pair(first_factor_digit, second_factor_digit));
+        }
+
+        bool valid = reader.good() && reader.at_end() && depth <= num_of_digits(n, base);
+
+        for(std::vector<digit_pair>::size_type i = 0;valid && i < path.size();i++)
+        {
+            valid = path[i].first < digit_base && path[i].second < digit_base;
+        }
+
+        if(!valid)
+        {
+            options.checkpoint->reject("damaged path");
+            path.clear();
+        }
+    }
+
+    search_control<number> control(options.checkpoint, path, options.token);
+
+    return search(root, &control);
+}
+
+#endif /* __PARALLEL_SEARCH_H__ */
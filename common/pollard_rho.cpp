@@ -0,0 +1,263 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "cancellation.h"
+#include "common.h"
+#include "pollard_rho.h"
+#include "prime_sieve.h"
+
+using namespace std;
+
+/* number of steps whose differences are multiplied up before taking a gcd */
+#define GCD_BATCH 100
+
+/* factors below this are searched by trial division */
+#define TRIAL_DIVISION_LIMIT 1024
+
+/* arithmetic modulo an odd n < 2^64 on numbers in montgomery form
+ * (x is represented by x * 2^64 mod n) */
+class montgomery
+{
+public:
+    montgomery(const uint64_t &n) : n(n)
+    {
+        /* newton's iteration for n^-1 mod 2^64, every step doubles the
+         * number of correct bits (n * n = 1 mod 8 gives the first 3) */
+        uint64_t inverse = n;
+        for(int i = 0;i < 5;i++) inverse *= 2 - n * inverse;
+        n_neg_inverse = -inverse;
+
+        one = static_cast<uint64_t>((static_cast<uint128>(1) << 64) % n);
+    }
+
+    /* this function returns x * y * 2^-64 mod n */
+    uint64_t multiply(const uint64_t &x, const uint64_t &y) const
+    {
+        uint128 t = static_cast<uint128>(x) * y;
+        uint64_t m = static_cast<uint64_t>(t) * n_neg_inverse;
+        uint128 mn = static_cast<uint128>(m) * n;
+        /* the low halves of t and mn add up to 0 mod 2^64 */
+        uint128 r = (t >> 64) + (mn >> 64) + (static_cast<uint64_t>(t) != 0);
+
+        return static_cast<uint64_t>((r >= n) ? r - n : r);
+    }
+
+    uint64_t add(const uint64_t &x, const uint64_t &y) const
+    {
+        uint64_t s = x + y;
+        return (s < x || s >= n) ? s - n : s;
+    }
+
+    /* this function returns |x - y| */
+    uint64_t distance(const uint64_t &x, const uint64_t &y) const
+    {
+        return (x > y) ? x - y : y - x;
+    }
+
+    const uint64_t &modulus() const
+    {
+        return n;
+    }
+
+    /* the montgomery form of 1 */
+    const uint64_t &unit() const
+    {
+        return one;
+    }
+
+private:
+    uint64_t n;
+    uint64_t n_neg_inverse;
+    uint64_t one;
+};
+
+static inline uint64_t gcd(uint64_t x, uint64_t y)
+{
+    if(x == 0) return y;
+    if(y == 0) return x;
+
+    int shift = __builtin_ctzll(x | y);
+    x >>= __builtin_ctzll(x);
+
+    while(y != 0)
+    {
+        y >>= __builtin_ctzll(y);
+        if(x > y) swap(x, y);
+        y -= x;
+    }
+
+    return x << shift;
+}
+
+/* this function searches a non-trivial factor of the odd composite n < 2^64
+ * with the polynomial x^2 + c, it returns n if the cycle closed before and 0
+ * if remaining (which is decreased by the number of steps done) ran out or
+ * token (if not NULL) was cancelled */
+static uint64_t brent(const montgomery &m, const uint64_t &c, uint64_t &remaining, cancellation_token *token)
+{
+    const uint64_t &n = m.modulus();
+    uint64_t x = 0, y = m.unit(), ys = y, q = m.unit();
+    uint64_t g = 1;
+
+    for(uint64_t r = 1;g == 1;r *= 2)
+    {
+        /* every round takes 2 * r steps */
+        if(remaining < 2 * r) return 0;
+        remaining -= 2 * r;
+
+        x = y;
+
+        for(uint64_t k = 0;k < r;k += CANCELLATION_POLL_INTERVAL)
+        {
+            uint64_t batch = min<uint64_t>(CANCELLATION_POLL_INTERVAL, r - k);
+
+            if(token != NULL && token->charge(batch)) return 0;
+
+            for(uint64_t i = 0;i < batch;i++)
+            {
+                y = m.add(m.multiply(y, y), c);
+            }
+        }
+
+        for(uint64_t k = 0;k < r && g == 1;k += GCD_BATCH)
+        {
+            ys = y;
+
+            for(uint64_t i = 0;i < min<uint64_t>(GCD_BATCH, r - k);i++)
+            {
+                y = m.add(m.multiply(y, y), c);
+                q = m.multiply(q, m.distance(x, y));
+            }
+
+            /* q is a multiple of the product by 2^64 which is prime to n */
+            g = gcd(q, n);
+
+            /* one batch in every CANCELLATION_POLL_INTERVAL steps charges them */
+            if(token != NULL && k % CANCELLATION_POLL_INTERVAL < GCD_BATCH && token->charge(CANCELLATION_POLL_INTERVAL)) return 0;
+        }
+    }
+
+    /* the batch contained a multiple of n, redo it one step at a time */
+    if(g == n)
+    {
+        do
+        {
+            ys = m.add(m.multiply(ys, ys), c);
+            g = gcd(m.distance(x, ys), n);
+        } while(g == 1);
+    }
+
+    return g;
+}
+
+/* the same for arbitrary n using GMP */
+static mpz_class brent(const mpz_class &n, const mpz_class &c, uint64_t &remaining, cancellation_token *token)
+{
+    mpz_class x = 0, y = 2, ys = y, q = 1;
+    mpz_class g = 1;
+
+    for(uint64_t r = 1;g == 1;r *= 2)
+    {
+        if(remaining < 2 * r) return 0;
+        remaining -= 2 * r;
+
+        x = y;
+
+        for(uint64_t k = 0;k < r;k += CANCELLATION_POLL_INTERVAL)
+        {
+            uint64_t batch = min<uint64_t>(CANCELLATION_POLL_INTERVAL, r - k);
+
+            if(token != NULL && token->charge(batch)) return 0;
+
+            for(uint64_t i = 0;i < batch;i++)
+            {
+                y = (y * y + c) % n;
+            }
+        }
+
+        for(uint64_t k = 0;k < r && g == 1;k += GCD_BATCH)
+        {
+            ys = y;
+
+            for(uint64_t i = 0;i < min<uint64_t>(GCD_BATCH, r - k);i++)
+            {
+                y = (y * y + c) % n;
+                q = q * abs(x - y) % n;
+            }
+
+            g = gcd(q, n);
+
+            /* one batch in every CANCELLATION_POLL_INTERVAL steps charges them */
+            if(token != NULL && k % CANCELLATION_POLL_INTERVAL < GCD_BATCH && token->charge(CANCELLATION_POLL_INTERVAL)) return 0;
+        }
+    }
+
+    if(g == n)
+    {
+        do
+        {
+            ys = (ys * ys + c) % n;
+            g = gcd(abs(x - ys), n);
+        } while(g == 1);
+    }
+
+    return g;
+}
+
+mpz_class pollard_rho(const mpz_class &n, uint64_t iterations, cancellation_token *token)
+{
+    uint64_t remaining = (iterations == 0) ? UINT64_MAX : iterations;
+
+    /* tiny factors are found faster by trial division (and the iteration can
+     * fail for every polynomial if n is the square of a tiny prime) */
+    prime_sieve primes;
+
+    for(uint64_t p = primes.next();p < TRIAL_DIVISION_LIMIT;p = primes.next())
+    {
+        if(n % p == 0)
+        {
+            return p;
+        }
+    }
+
+    if(bit_length(n) <= 64)
+    {
+        montgomery m(from_mpz<uint64_t>(n));
+        uint64_t g = m.modulus();
+
+        /* a cycle without a factor only means that another polynomial has to be used */
+        for(uint64_t c = 1;g == m.modulus();c++)
+        {
+            g = brent(m, c % m.modulus(), remaining, token);
+        }
+
+        return to_mpz(g);
+    }
+
+    mpz_class g = n;
+
+    for(unsigned long int c = 1;g == n;c++)
+    {
+        g = brent(n, c, remaining, token);
+    }
+
+    return g;
+}
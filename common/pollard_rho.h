@@ -0,0 +1,36 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __POLLARD_RHO_H__
+#define __POLLARD_RHO_H__
+
+#include <cstdint>
+
+#include <gmpxx.h>
+
+class cancellation_token;
+
+/* this function returns a non-trivial factor of the composite n using
+ * pollard's rho algorithm with brent's cycle detection, or 0 if none was
+ * found within iterations steps of the iteration (0 means no limit) or
+ * before token (if not NULL), which is charged with the steps, was
+ * cancelled */
+mpz_class pollard_rho(const mpz_class &n, uint64_t iterations = 0, cancellation_token *token = NULL);
+
+#endif /* __POLLARD_RHO_H__ */
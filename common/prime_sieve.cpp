@@ -0,0 +1,108 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <unistd.h>
+
+#include "prime_sieve.h"
+
+using namespace std;
+
+/* this function returns the size of a segment in bytes (the size of the level
+ * 1 data cache if it is known) */
+static vector<unsigned char>::size_type segment_bytes()
+{
+    long size = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+
+    return (size > 0) ? size : 32768;
+}
+
+prime_sieve::prime_sieve(uint64_t start) : first_prime(0), low(0), position(0), segment(segment_bytes()), base_limit(1)
+{
+    if(start <= 2)
+    {
+        first_prime = 2;
+        start = 3;
+    }
+
+    /* the smallest odd number >= start */
+    low = start | 1;
+
+    sieve_segment();
+}
+
+void prime_sieve::extend_base_primes(uint64_t limit)
+{
+    vector<bool> composite(limit + 1, false);
+
+    base_primes.clear();
+
+    for(uint64_t i = 3;i <= limit;i += 2)
+    {
+        if(!composite[i])
+        {
+            base_primes.push_back(i);
+
+            for(uint64_t j = i * i;j <= limit;j += 2 * i)
+            {
+                composite[j] = true;
+            }
+        }
+    }
+
+    base_limit = limit;
+}
+
+void prime_sieve::sieve_segment()
+{
+    uint64_t high = low + 2 * segment.size();
+    uint64_t root = sqrt(static_cast<double>(high));
+
+    while(root * root > high) root--;
+    while((root + 1) * (root + 1) <= high) root++;
+
+    if(base_limit < root)
+    {
+        /* grow geometrically so that the base primes are rarely recomputed */
+        extend_base_primes(max(root, 2 * base_limit));
+    }
+
+    fill(segment.begin(), segment.end(), 0);
+    position = 0;
+
+    for(vector<uint32_t>::size_type i = 0;i < base_primes.size();i++)
+    {
+        uint64_t p = base_primes[i];
+        uint64_t multiple = p * p;
+
+        if(multiple >= high) break;
+
+        if(multiple < low)
+        {
+            multiple = ((low + p - 1) / p) * p;
+            if(multiple % 2 == 0) multiple += p;
+        }
+
+        for(uint64_t j = (multiple - low) / 2;j < segment.size();j += p)
+        {
+            segment[j] = 1;
+        }
+    }
+}
@@ -0,0 +1,79 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PRIME_SIEVE_H__
+#define __PRIME_SIEVE_H__
+
+#include <cstdint>
+#include <vector>
+
+/* this class enumerates the primes in ascending order using a segmented sieve
+ * of eratosthenes. only odd numbers are stored (one byte each) and a segment
+ * has the size of the level 1 data cache, so sieving a segment never leaves
+ * the cache. */
+class prime_sieve
+{
+public:
+    /* the first prime returned is the smallest prime >= start */
+    explicit prime_sieve(uint64_t start = 2);
+
+    /* this function returns the next prime */
+    uint64_t next()
+    {
+        if(first_prime != 0)
+        {
+            uint64_t p = first_prime;
+            first_prime = 0;
+            return p;
+        }
+
+        for(;;)
+        {
+            while(position < segment.size())
+            {
+                if(!segment[position])
+                {
+                    return low + 2 * position++;
+                }
+
+                position++;
+            }
+
+            low += 2 * segment.size();
+            sieve_segment();
+        }
+    }
+
+private:
+    void sieve_segment();
+    void extend_base_primes(uint64_t limit);
+
+    /* 2 is not contained in the segments */
+    uint64_t first_prime;
+    /* the (odd) number corresponding to segment[0] */
+    uint64_t low;
+    std::vector<unsigned char>::size_type position;
+    /* segment[i] != 0 if low + 2 * i is composite */
+    std::vector<unsigned char> segment;
+    /* the odd primes up to base_limit */
+    std::vector<uint32_t> base_primes;
+    uint64_t base_limit;
+};
+
+#endif /* __PRIME_SIEVE_H__ */
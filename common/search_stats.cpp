@@ -0,0 +1,137 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <mutex>
+
+#include "search_stats.h"
+
+using namespace std;
+
+/* the statistics of the threads which already exited */
+static mutex totals_lock;
+static search_stats totals;
+
+/* the statistics of one thread, added to the totals when the thread exits */
+struct thread_stats
+{
+    ~thread_stats()
+    {
+        lock_guard<mutex> lock(totals_lock);
+        totals.merge(stats);
+    }
+
+    search_stats stats;
+};
+
+search_stats &search_stats::local()
+{
+    static thread_local thread_stats local_stats;
+    return local_stats.stats;
+}
+
+void search_stats::merge(const search_stats &other)
+{
+    if(other.depths.size() > depths.size()) depths.resize(other.depths.size());
+
+    for(vector<depth_stats>::size_type i = 0;i < other.depths.size();i++)
+    {
+        depths[i].nodes += other.depths[i].nodes;
+        depths[i].children += other.depths[i].children;
+        depths[i].product_prunes += other.depths[i].product_prunes;
+        depths[i].interval_prunes += other.depths[i].interval_prunes;
+        depths[i].equation_rejections += other.depths[i].equation_rejections;
+        depths[i].inverse_failures += other.depths[i].inverse_failures;
+        depths[i].nanoseconds += other.depths[i].nanoseconds;
+    }
+}
+
+search_stats collect_search_stats()
+{
+    search_stats &local = search_stats::local();
+    lock_guard<mutex> lock(totals_lock);
+    search_stats result = totals;
+
+    result.merge(local);
+    totals.depths.clear();
+    local.depths.clear();
+
+    return result;
+}
+
+void search_stats::print(ostream &out, bool json) const
+{
+    depth_stats sum;
+    digit_counter max_depth = 0;
+    char line[256];
+
+    for(vector<depth_stats>::size_type i = 0;i < depths.size();i++)
+    {
+        if(depths[i].nodes > 0) max_depth = i;
+
+        sum.nodes += depths[i].nodes;
+        sum.children += depths[i].children;
+        sum.product_prunes += depths[i].product_prunes;
+        sum.interval_prunes += depths[i].interval_prunes;
+        sum.equation_rejections += depths[i].equation_rejections;
+        sum.inverse_failures += depths[i].inverse_failures;
+        sum.nanoseconds += depths[i].nanoseconds;
+    }
+
+    if(json)
+    {
+        out << "{\"max_depth\": " << max_depth << ", \"nodes\": " << sum.nodes << ", \"seconds\": " << sum.nanoseconds / 1e9 << ", \"depths\": [";
+
+        for(vector<depth_stats>::size_type i = 0;i < depths.size();i++)
+        {
+            const depth_stats &d = depths[i];
+
+            out << ((i > 0) ? ", " : "") << "{\"depth\": " << i << ", \"nodes\": " << d.nodes << ", \"branching\": " << ((d.nodes > 0) ? static_cast<double>(d.children) / d.nodes : 0)
+                << ", \"product_prunes\": " << d.product_prunes << ", \"interval_prunes\": " << d.interval_prunes << ", \"equation_rejections\": " << d.equation_rejections
+                << ", \"inverse_failures\": " << d.inverse_failures << ", \"seconds\": " << d.nanoseconds / 1e9 << "}";
+        }
+
+        out << "]}" << endl;
+        return;
+    }
+
+    if(empty())
+    {
+        out << "no search statistics were collected." << endl;
+        return;
+    }
+
+    out << "search statistics (maximal depth " << max_depth << "):" << endl;
+    out << "depth           nodes branching  product>n   interval   rejected  no inverse    seconds" << endl;
+
+    for(vector<depth_stats>::size_type i = 0;i < depths.size();i++)
+    {
+        const depth_stats &d = depths[i];
+
+        snprintf(line, sizeof(line), "%5lu %15llu %9.3f %10llu %10llu %10llu %11llu %10.6f", static_cast<unsigned long>(i), static_cast<unsigned long long>(d.nodes),
+                 (d.nodes > 0) ? static_cast<double>(d.children) / d.nodes : 0.0, static_cast<unsigned long long>(d.product_prunes), static_cast<unsigned long long>(d.interval_prunes),
+                 static_cast<unsigned long long>(d.equation_rejections), static_cast<unsigned long long>(d.inverse_failures), d.nanoseconds / 1e9);
+        out << line << endl;
+    }
+
+    snprintf(line, sizeof(line), "total %15llu %9.3f %10llu %10llu %10llu %11llu %10.6f", static_cast<unsigned long long>(sum.nodes),
+             (sum.nodes > 0) ? static_cast<double>(sum.children) / sum.nodes : 0.0, static_cast<unsigned long long>(sum.product_prunes), static_cast<unsigned long long>(sum.interval_prunes),
+             static_cast<unsigned long long>(sum.equation_rejections), static_cast<unsigned long long>(sum.inverse_failures), sum.nanoseconds / 1e9);
+    out << line << endl;
+}
@@ -0,0 +1,155 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* statistics of the digit-by-digit search trees. the counters are only
+ * compiled in if SEARCH_STATS is set (make STATS=1), otherwise the STATS_*
+ * macros expand to nothing and the search is not slowed down at all. */
+
+#ifndef __SEARCH_STATS_H__
+#define __SEARCH_STATS_H__
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "common.h"
+
+/* the counters of all nodes at one depth of the search tree */
+struct depth_stats
+{
+    depth_stats() : nodes(0), children(0), product_prunes(0), interval_prunes(0), equation_rejections(0), inverse_failures(0), nanoseconds(0) {}
+
+    /* calls of find_next_digits */
+    uint64_t nodes;
+    /* digit pairs which were searched further (or recorded as a subtree) */
+    uint64_t children;
+    /* loops which were cut off because a * b > n */
+    uint64_t product_prunes;
+    /* children which can't be completed to a factorisation with a <= sqrt(n),
+     * see bound_factors */
+    uint64_t interval_prunes;
+    /* digit pairs which do not solve the digit equation */
+    uint64_t equation_rejections;
+    /* first factor digits without a second one because a_0 * b = target has
+     * no solution modulo the base */
+    uint64_t inverse_failures;
+    /* time spent in the nodes without the time of their children */
+    uint64_t nanoseconds;
+};
+
+class search_stats
+{
+public:
+    search_stats() : children_nanoseconds(0) {}
+
+    /* this function returns the statistics of the calling thread, they are
+     * added to the totals when the thread exits */
+    static search_stats &local();
+
+    depth_stats &at(const digit_counter &depth)
+    {
+        if(depth >= depths.size()) depths.resize(depth + 1);
+        return depths[depth];
+    }
+
+    void merge(const search_stats &other);
+
+    bool empty() const
+    {
+        return depths.empty();
+    }
+
+    /* this function writes the statistics as a table or as json */
+    void print(std::ostream &out, bool json) const;
+
+    std::vector<depth_stats> depths;
+    /* the time spent in the children of the current node so far */
+    uint64_t children_nanoseconds;
+};
+
+/* this function returns the statistics of all threads (the ones which are
+ * still running excluded) and resets them */
+search_stats collect_search_stats();
+
+/* this class measures the time of one node from start to stop, the time of
+ * its children (which are measured by their own clocks) is subtracted */
+class search_node_clock
+{
+public:
+    void start(const digit_counter &node_depth)
+    {
+        stats = &search_stats::local();
+        depth = node_depth;
+        begin = std::chrono::steady_clock::now();
+        stats->at(depth).nodes++;
+        saved_children_nanoseconds = stats->children_nanoseconds;
+        stats->children_nanoseconds = 0;
+    }
+
+    void stop()
+    {
+        uint64_t total = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+
+        stats->at(depth).nanoseconds += total - std::min(total, stats->children_nanoseconds);
+        stats->children_nanoseconds = saved_children_nanoseconds + total;
+    }
+
+private:
+    search_stats *stats;
+    digit_counter depth;
+    std::chrono::steady_clock::time_point begin;
+    uint64_t saved_children_nanoseconds;
+};
+
+/* this class measures the time of the node of the scope it lives in */
+class search_node_timer
+{
+public:
+    explicit search_node_timer(const digit_counter &depth)
+    {
+        clock.start(depth);
+    }
+
+    ~search_node_timer()
+    {
+        clock.stop();
+    }
+
+private:
+    search_node_clock clock;
+};
+
+#if SEARCH_STATS
+/* counts the node at depth and measures its time until the end of the scope */
+#define STATS_NODE(depth) search_node_timer search_stats_timer(depth)
+/* the same for searches without recursion, clock is a search_node_clock */
+#define STATS_NODE_START(clock, depth) ((clock).start(depth))
+#define STATS_NODE_STOP(clock) ((clock).stop())
+/* increments counter (a member of depth_stats) of depth */
+#define STATS_COUNT(depth, counter) (search_stats::local().at(depth).counter++)
+#else
+#define STATS_NODE(depth)
+#define STATS_NODE_START(clock, depth) ((void)0)
+#define STATS_NODE_STOP(clock) ((void)0)
+#define STATS_COUNT(depth, counter) ((void)0)
+#endif
+
+#endif /* __SEARCH_STATS_H__ */
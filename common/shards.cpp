@@ -0,0 +1,395 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "shards.h"
+
+using namespace std;
+
+/* a worker process as seen by the coordinator */
+struct shard_worker
+{
+    pid_t pid;
+    /* the coordinator's end of the socket, -1 if the worker is gone */
+    int fd;
+    bool busy;
+    uint64_t shard;
+    /* the incomplete line which was read last */
+    string input;
+};
+
+/* this function writes all of text to fd, it returns false if the other
+ * end is gone */
+static bool write_line(int fd, const string &text)
+{
+    string::size_type written = 0;
+
+    while(written < text.size())
+    {
+        /* a dead worker must not stop the coordinator with SIGPIPE */
+        ssize_t r = send(fd, text.data() + written, text.size() - written, MSG_NOSIGNAL);
+
+        if(r < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if(r <= 0)
+        {
+            return false;
+        }
+
+        written += r;
+    }
+
+    return true;
+}
+
+/* this function reads from fd into input until it contains a whole line and
+ * removes that line from it, it returns false if the other end is gone */
+static bool read_line(int fd, string &input, string &line)
+{
+    char buffer[256];
+    string::size_type end;
+
+    while((end = input.find('\n')) == string::npos)
+    {
+        ssize_t r = read(fd, buffer, sizeof(buffer));
+
+        if(r < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if(r <= 0)
+        {
+            return false;
+        }
+
+        input.append(buffer, r);
+    }
+
+    line = input.substr(0, end);
+    input.erase(0, end + 1);
+
+    return true;
+}
+
+/* this function appends what fd has to input without waiting for more, it
+ * returns false if the other end is gone */
+static bool receive(int fd, string &input)
+{
+    char buffer[256];
+
+    for(;;)
+    {
+        ssize_t r = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+
+        if(r < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if(r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            return true;
+        }
+
+        if(r <= 0)
+        {
+            return false;
+        }
+
+        input.append(buffer, r);
+    }
+}
+
+/* this function reads the answer "shard divisor" of a worker from line, it
+ * returns false if line isn't one */
+static bool parse_answer(const string &line, uint64_t &shard, mpz_class &divisor)
+{
+    string::size_type space = line.find(' ');
+
+    if(space == 0 || space == string::npos || space + 1 == line.size() || line.find_first_not_of("0123456789 ") != string::npos || line.find(' ', space + 1) != string::npos)
+    {
+        return false;
+    }
+
+    shard = strtoull(line.c_str(), NULL, 10);
+
+    return divisor.set_str(line.substr(space + 1), 10) == 0;
+}
+
+/* the loop of a worker process, it searches the shards it gets on fd until
+ * the coordinator closes it */
+static void run_worker(int fd, const shard_search &search)
+{
+    string input;
+    string line;
+
+    while(read_line(fd, input, line))
+    {
+        uint64_t shard = strtoull(line.c_str(), NULL, 10);
+        mpz_class divisor = search(shard);
+
+        if(!write_line(fd, to_string(shard) + " " + divisor.get_str() + "\n"))
+        {
+            return;
+        }
+    }
+}
+
+/* this function stops the worker (if it is still there) and waits for it */
+static void stop_worker(shard_worker &worker)
+{
+    if(worker.fd < 0)
+    {
+        return;
+    }
+
+    kill(worker.pid, SIGKILL);
+    close(worker.fd);
+    worker.fd = -1;
+
+    while(waitpid(worker.pid, NULL, 0) < 0 && errno == EINTR);
+}
+
+mpz_class search_shards(const uint64_t &count, unsigned int processes, const shard_search &search)
+{
+    vector<shard_worker> workers;
+    /* the shards of dead workers, they come before next_shard */
+    set<uint64_t> pending;
+    uint64_t next_shard = 0;
+    vector<bool> done(count, false);
+    /* the number of shards below best which were searched */
+    uint64_t done_below_best = 0;
+    /* the lowest shard with a divisor, count if there is none */
+    uint64_t best = count;
+    mpz_class best_divisor = 0;
+
+    /* the workers get copies of everything the caller prepared */
+    cout.flush();
+    cerr.flush();
+
+    for(unsigned int i = 0;i < processes;i++)
+    {
+        int fds[2];
+
+        if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        {
+            break;
+        }
+
+        pid_t pid = fork();
+
+        if(pid == 0)
+        {
+            close(fds[0]);
+
+            for(vector<shard_worker>::size_type j = 0;j < workers.size();j++)
+            {
+                close(workers[j].fd);
+            }
+
+            run_worker(fds[1], search);
+            _exit(0);
+        }
+
+        close(fds[1]);
+
+        if(pid < 0)
+        {
+            close(fds[0]);
+            break;
+        }
+
+        workers.push_back(shard_worker{pid, fds[0], false, 0, string()});
+    }
+
+#if DEBUG
+    cout << "searching " << count << " shards using " << workers.size() << " worker processes." << endl;
+#endif
+
+    for(;;)
+    {
+        vector<pollfd> fds;
+        vector<vector<shard_worker>::size_type> polled;
+
+        /* the lowest shards which are left go to the idle workers */
+        for(vector<shard_worker>::size_type i = 0;i < workers.size();i++)
+        {
+            shard_worker &worker = workers[i];
+
+            if(worker.fd < 0 || worker.busy)
+            {
+                continue;
+            }
+
+            if(!pending.empty() && *pending.begin() < best)
+            {
+                worker.shard = *pending.begin();
+                pending.erase(pending.begin());
+            }
+            else if(next_shard < best)
+            {
+                worker.shard = next_shard++;
+            }
+            else
+            {
+                continue;
+            }
+
+            worker.busy = true;
+
+            if(!write_line(worker.fd, to_string(worker.shard) + "\n"))
+            {
+                /* the worker is gone, the shard goes to the next one */
+                pending.insert(worker.shard);
+                stop_worker(worker);
+            }
+        }
+
+        if(done_below_best == best)
+        {
+            break;
+        }
+
+        for(vector<shard_worker>::size_type i = 0;i < workers.size();i++)
+        {
+            if(workers[i].fd >= 0 && workers[i].busy)
+            {
+                fds.push_back(pollfd{workers[i].fd, POLLIN, 0});
+                polled.push_back(i);
+            }
+        }
+
+        /* without workers the coordinator searches the rest itself */
+        if(fds.empty())
+        {
+            for(uint64_t shard = 0;shard < best;shard++)
+            {
+                mpz_class divisor = done[shard] ? mpz_class(0) : search(shard);
+
+                if(divisor != 0)
+                {
+                    best_divisor = divisor;
+                    break;
+                }
+            }
+
+            break;
+        }
+
+        if(poll(fds.data(), fds.size(), -1) < 0)
+        {
+            continue;
+        }
+
+        for(vector<pollfd>::size_type i = 0;i < fds.size();i++)
+        {
+            shard_worker &worker = workers[polled[i]];
+            string line;
+            string::size_type end;
+            uint64_t shard = 0;
+            mpz_class divisor;
+
+            if(fds[i].revents == 0)
+            {
+                continue;
+            }
+
+            if(!receive(worker.fd, worker.input))
+            {
+#if DEBUG
+                cout << "worker " << worker.pid << " died, shard " << worker.shard << " is searched again." << endl;
+#endif
+                pending.insert(worker.shard);
+                stop_worker(worker);
+                continue;
+            }
+
+            /* the rest of the line comes later */
+            if((end = worker.input.find('\n')) == string::npos)
+            {
+                continue;
+            }
+
+            line = worker.input.substr(0, end);
+            worker.input.erase(0, end + 1);
+
+            /* a worker which answers something else is treated like a dead
+             * one */
+            if(!parse_answer(line, shard, divisor) || shard != worker.shard)
+            {
+#if DEBUG
+                cout << "worker " << worker.pid << " answered \"" << line << "\", shard " << worker.shard << " is searched again." << endl;
+#endif
+                pending.insert(worker.shard);
+                stop_worker(worker);
+                continue;
+            }
+
+            worker.busy = false;
+
+            if(done[shard])
+            {
+                continue;
+            }
+
+            done[shard] = true;
+
+            if(divisor != 0 && shard < best)
+            {
+                /* the shards between shard and best don't count anymore */
+                done_below_best = 0;
+
+                for(uint64_t j = 0;j < shard;j++)
+                {
+                    done_below_best += done[j];
+                }
+
+                best = shard;
+                best_divisor = divisor;
+            }
+            else if(shard < best)
+            {
+                done_below_best++;
+            }
+        }
+    }
+
+    for(vector<shard_worker>::size_type i = 0;i < workers.size();i++)
+    {
+        stop_worker(workers[i]);
+    }
+
+    return best_divisor;
+}
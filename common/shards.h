@@ -0,0 +1,51 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* the trial divisions with --processes: the range of candidates is cut into
+ * shards which a coordinator hands to worker processes. a worker gets the
+ * index of a shard as a line "shard\n" and answers with the line
+ * "shard divisor\n" where divisor is the smallest divisor in the shard or 0,
+ * so the workers only need a stream to the coordinator (a unix socket
+ * here). */
+
+#ifndef __SHARDS_H__
+#define __SHARDS_H__
+
+#include <cstdint>
+#include <functional>
+
+#include "common.h"
+
+/* the range is cut into this many shards per worker process, so a shard of
+ * a dead worker or behind a divisor is only a small part of it */
+#define SHARDS_PER_PROCESS 64
+
+/* this function returns the smallest divisor in the shard, 0 if there is
+ * none */
+typedef std::function<mpz_class(uint64_t)> shard_search;
+
+/* this function searches the shards 0, ..., count - 1 with search on
+ * processes forked worker processes, in ascending order. the shard of a
+ * worker which dies is given to another one (or searched by the coordinator
+ * if none is left). as soon as the lowest shard with a divisor is known and
+ * all shards below it were searched, all workers are stopped and its divisor
+ * is returned, 0 if no shard has one. */
+mpz_class search_shards(const uint64_t &count, unsigned int processes, const shard_search &search);
+
+#endif /* __SHARDS_H__ */
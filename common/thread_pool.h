@@ -0,0 +1,107 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* this function returns the number of worker threads to use for the
+ * requested number of threads (0 means one per hardware thread) */
+inline unsigned int worker_count(unsigned int threads)
+{
+    if(threads == 0)
+    {
+        threads = std::thread::hardware_concurrency();
+    }
+
+    return (threads == 0) ? 1 : threads;
+}
+
+/* this function runs run_task(0), ..., run_task(tasks - 1) on threads worker
+ * threads (the calling thread being one of them). the tasks are dealt out
+ * round-robin, every worker takes its own tasks in ascending order and steals
+ * the highest pending task of another worker once its own queue is empty,
+ * so low task numbers are always started first. */
+inline void run_work_stealing(std::size_t tasks, unsigned int threads, const std::function<void(std::size_t)> &run_task)
+{
+    std::vector<std::deque<std::size_t>> queues(threads);
+    std::vector<std::mutex> locks(threads);
+    std::vector<std::thread> workers;
+
+    for(std::size_t i = 0;i < tasks;i++)
+    {
+        queues[i % threads].push_back(i);
+    }
+
+    std::function<void(unsigned int)> worker = [&](unsigned int self)
+    {
+        for(;;)
+        {
+            std::size_t task = 0;
+            bool have_task = false;
+
+            {
+                std::lock_guard<std::mutex> lock(locks[self]);
+                if(!queues[self].empty())
+                {
+                    task = queues[self].front();
+                    queues[self].pop_front();
+                    have_task = true;
+                }
+            }
+
+            for(unsigned int i = 1;i < threads && !have_task;i++)
+            {
+                unsigned int victim = (self + i) % threads;
+
+                std::lock_guard<std::mutex> lock(locks[victim]);
+                if(!queues[victim].empty())
+                {
+                    task = queues[victim].back();
+                    queues[victim].pop_back();
+                    have_task = true;
+                }
+            }
+
+            /* tasks never create new tasks, so all queues stay empty now */
+            if(!have_task) return;
+
+            run_task(task);
+        }
+    };
+
+    for(unsigned int i = 1;i < threads;i++)
+    {
+        workers.emplace_back(worker, i);
+    }
+
+    worker(0);
+
+    for(std::vector<std::thread>::size_type i = 0;i < workers.size();i++)
+    {
+        workers[i].join();
+    }
+}
+
+#endif /* __THREAD_POOL_H__ */
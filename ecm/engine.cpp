@@ -0,0 +1,88 @@
+/*
+ * Lenstra's elliptic curve method with montgomery curves.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <algorithm>
+
+#include "../common/cancellation.h"
+#include "../common/common.h"
+#include "../common/engine.h"
+#include "../common/ecm.h"
+
+using namespace std;
+
+static const char parameters_help[] =
+    "\t\tdigits=d\tstart with the preset for factors of d digits\n"
+    "\t\t\t\t(15, 20, ..., 60), default 15.\n"
+    "\t\tb1=bound\tthe stage 1 bound, default from the preset.\n"
+    "\t\tb2=bound\tthe stage 2 bound for b1, default 100 * b1.\n"
+    "\t\tcurves=c\tthe number of curves to run with b1 before\n"
+    "\t\t\t\tcontinuing with the next preset.\n";
+
+template<typename number> static pair<number, number> factorise(const number &n, const number &base, const digit_counter &steps, const factorise_options &options)
+{
+    // not used
+    (void)base;
+    (void)steps;
+
+    if(n < 4 || is_prime(n))
+    {
+        return make_pair(1, n);
+    }
+
+    mpz_class m = to_mpz(n);
+    mpz_class d = 0;
+    unsigned long int curve = 0;
+    size_t level = 0;
+    unsigned long int digits = options.parameter("digits", ecm_presets[0].digits);
+
+    while(level + 1 < ecm_preset_count && ecm_presets[level].digits < digits) level++;
+
+    /* explicitly given bounds are tried first, then the presets above them */
+    if(options.parameters.count("b1") != 0)
+    {
+        /* stage 2 leaves p = 2 to stage 1, so b1 is at least 2 */
+        unsigned long int b1 = max(options.parameter("b1", 0), 2UL);
+
+        while(level + 1 < ecm_preset_count && ecm_presets[level].b1 <= b1) level++;
+
+        unsigned long int curves = options.parameter("curves", ecm_presets[level].curves);
+
+        d = ecm(m, b1, options.parameter("b2", 100 * b1), curves, curve, options.threads, options.token);
+        curve += curves;
+    }
+
+    /* for a composite n some curve finds a factor eventually, unless the
+     * budget runs out before */
+    if(d == 0)
+    {
+        d = ecm_factor(m, level, 0, options.threads, curve, options.token);
+    }
+
+    if(d == 0)
+    {
+        return make_pair(1, n);
+    }
+
+    number f = from_mpz<number>(d);
+
+    return make_pair(min<number>(f, n / f), max<number>(f, n / f));
+}
+
+DEFINE_ENGINE(ecm_engine, "ecm", factorise, keep_base, square_root_bits, false, true, false, false, parameters_help)
@@ -0,0 +1,771 @@
+/*
+ * A slightly improved trial division algorithm which skips integers which can
+ * never be a factor of the starting number.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider (idea, implementation)
+ *  Copyright (C) 2015 Lorenz Oberhammer (proofs)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <vector>
+#include <tuple>
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#include "../common/auto_base.h"
+#include "../common/cancellation.h"
+#include "../common/checkpoint.h"
+#include "../common/common.h"
+#include "../common/engine.h"
+#include "../common/shards.h"
+#include "../common/thread_pool.h"
+#include "wheel_cache.h"
+
+using namespace std;
+
+/* the number of candidates in one block of the parallel trial division */
+#define BLOCK_CANDIDATES 65536
+
+/* a block checks whether it was cancelled after this many candidates */
+#define CANCEL_CHECK_INTERVAL 4096
+
+/* the maximal number of residues of a wheel for several bases */
+#define MAX_CRT_WHEEL (1UL << 26)
+
+/* the largest wheel (in residues) which --auto-base chooses */
+#define MAX_AUTO_WHEEL (1UL << 24)
+
+/* the bases which --auto-base considers, a prime base can't skip anything */
+static const uint64_t wheel_base_candidates[] = {4, 6, 10, 12, 30, 60, 210, 420, 2310, 30030};
+
+static const char parameters_help[] =
+    "\t\twheel-cache=dir\tkeeps the increment tables in the directory dir,\n"
+    "\t\t\t\tlater runs with the same base, steps and n\n"
+    "\t\t\t\tmodulo base^steps map them instead of\n"
+    "\t\t\t\trebuilding them.\n"
+    "\t\tbases=b1,b2,...\tcombines the residuals of the pairwise coprime\n"
+    "\t\t\t\tbases b1, b2, ... (each to the power steps)\n"
+    "\t\t\t\tinto one wheel, base is not used then.\n";
+
+template<typename number> static inline void find_possible_factor_residuals(const number &n, const digit_counter &current_digit, vector<number> &possible_factor_residuals, const number &base, const number &first_factor_so_far, const number &second_factor_so_far, const digit_counter &steps, const number &carry, const number &previous_base)
+{
+    number a, b;
+    pair<bool, number> check;
+
+    for(number a_digit = 0;a_digit < base;a_digit++)
+    {
+        for(number b_digit = 0;b_digit < base;b_digit++)
+        {
+            a = first_factor_so_far;
+            b = second_factor_so_far;
+            set_digit(a, a_digit, previous_base);
+            set_digit(b, b_digit, previous_base);
+
+            if(a * b > n)
+            {
+                if(a < n) possible_factor_residuals.push_back(a);
+                break;
+            }
+
+            check = check_if_new_digits_solve_digit_equation(n, a, b, carry, current_digit, base, previous_base);
+
+            if(check.first)
+            {
+                if(current_digit + 1 < steps)
+                {
+                    find_possible_factor_residuals<number>(n, current_digit + 1, possible_factor_residuals, base, a, b, steps, check.second, previous_base * base);
+                }
+                else
+                {
+                    possible_factor_residuals.push_back(a);
+                }
+            }
+        }
+    }
+}
+
+/* this function writes a checkpoint of the trial division which continues
+ * with the candidate x and the increment current_increment of the wheel with
+ * increment_count increments */
+template<typename number> static void save_position(search_checkpoint *checkpoint, const number &x, const uint64_t &current_increment, const uint64_t &increment_count)
+{
+    checkpoint_writer position;
+
+    position.put(to_mpz(x));
+    position.put(current_increment);
+    position.put(increment_count);
+    checkpoint->save(position);
+}
+
+/* this function tries the candidates x, x + increments[current_increment],
+ * ... up to limit. it returns the first one which divides n, or 0 if there is
+ * none or if found (if not NULL) drops below block. */
+template<typename number> static number try_candidates(const number &n, number x, const number &limit, const uint32_t *increments, const uint64_t &increment_count, uint64_t current_increment, const atomic<uint64_t> *found, const uint64_t &block)
+{
+    for(uint64_t tried = 0;x <= limit;tried++)
+    {
+        if(n % x == 0)
+        {
+            return x;
+        }
+
+        if(found != NULL && tried % CANCEL_CHECK_INTERVAL == 0 && found->load(memory_order_relaxed) < block)
+        {
+            return 0;
+        }
+
+        x += increments[current_increment];
+
+        current_increment++;
+
+        if(current_increment >= increment_count)
+        {
+            current_increment = 0;
+        }
+    }
+
+    return 0;
+}
+
+/* this function does the trial division from start_number to limit on
+ * threads threads. the range is cut into blocks of whole cycles of the
+ * increments (so every block starts with the increment current_increment)
+ * which the threads take in ascending order. the lowest block which
+ * contains a divisor wins and cancels all blocks above it, so the result is
+ * the smallest divisor, the same as the one of the serial search. the
+ * checkpoints of checkpoint (if not NULL) are written between two blocks,
+ * they continue with the lowest block which isn't finished, so with
+ * checkpoints also the search on one thread runs here. the same holds for
+ * the budgets of token (if not NULL) which are charged after every block, a
+ * divisor which was found before they ran out may not be the smallest one. */
+template<typename number> static number parallel_trial_division(const number &n, const number &start_number, const number &limit, const uint32_t *increments, const uint64_t &increment_count, const uint64_t &current_increment, unsigned int threads, search_checkpoint *checkpoint, cancellation_token *token)
+{
+    number period = 0;
+    uint64_t cycles = max<uint64_t>(1, BLOCK_CANDIDATES / increment_count);
+    atomic<uint64_t> next_block(0);
+    atomic<uint64_t> found(UINT64_MAX);
+    mutex result_lock;
+    number result = 0;
+    /* the blocks which are being searched */
+    mutex running_lock;
+    set<uint64_t> running;
+    vector<thread> workers;
+
+    for(uint64_t i = 0;i < increment_count;i++)
+    {
+        period += increments[i];
+    }
+
+    number block_size = period * cycles;
+
+    function<void()> worker = [&]()
+    {
+        for(;;)
+        {
+            uint64_t block;
+
+            if(checkpoint != NULL)
+            {
+                lock_guard<mutex> lock(running_lock);
+
+                block = next_block.fetch_add(1);
+                running.insert(block);
+            }
+            else
+            {
+                block = next_block.fetch_add(1);
+            }
+
+            number x = start_number + block_size * block;
+
+            if(found.load() < block || x > limit || (token != NULL && token->cancelled()))
+            {
+                return;
+            }
+
+            number last = x + block_size - 1;
+
+            if(last > limit)
+            {
+                last = limit;
+            }
+
+            number divisor = try_candidates(n, x, last, increments, increment_count, current_increment, &found, block);
+
+            if(token != NULL)
+            {
+                token->cover(to_mpz(last - start_number + 1).get_d() / to_mpz(limit - start_number + 1).get_d());
+                token->charge(cycles * increment_count);
+            }
+
+            if(divisor != 0)
+            {
+                lock_guard<mutex> lock(result_lock);
+
+                if(block < found.load())
+                {
+                    result = divisor;
+                    found.store(block);
+                }
+            }
+
+            if(checkpoint != NULL)
+            {
+                lock_guard<mutex> lock(running_lock);
+
+                running.erase(block);
+
+                if(checkpoint_stop.load() || checkpoint->due())
+                {
+                    /* the block with the divisor is searched again after a
+                     * resume */
+                    uint64_t lowest = running.empty() ? next_block.load() : *running.begin();
+
+                    save_position(checkpoint, start_number + block_size * min(lowest, found.load()), current_increment, increment_count);
+                }
+            }
+        }
+    };
+
+    for(unsigned int i = 1;i < threads;i++)
+    {
+        workers.emplace_back(worker);
+    }
+
+    worker();
+
+    for(vector<thread>::size_type i = 0;i < workers.size();i++)
+    {
+        workers[i].join();
+    }
+
+    return result;
+}
+
+/* this function does the trial division from start_number to limit on
+ * processes worker processes (see search_shards). the range is cut into
+ * shards of whole cycles of the increments like the blocks of
+ * parallel_trial_division. */
+template<typename number> static number sharded_trial_division(const number &n, const number &start_number, const number &limit, const uint32_t *increments, const uint64_t &increment_count, const uint64_t &current_increment, unsigned int processes)
+{
+    number period = 0;
+    uint64_t count = static_cast<uint64_t>(processes) * SHARDS_PER_PROCESS;
+
+    if(start_number > limit)
+    {
+        return 0;
+    }
+
+    for(uint64_t i = 0;i < increment_count;i++)
+    {
+        period += increments[i];
+    }
+
+    number cycles = (limit - start_number) / period / count + 1;
+    number shard_size = period * cycles;
+
+    return from_mpz<number>(search_shards(count, processes, [&](uint64_t shard)
+    {
+        number x = start_number + shard_size * shard;
+
+        if(x > limit)
+        {
+            return mpz_class(0);
+        }
+
+        number last = x + shard_size - 1;
+
+        return to_mpz(try_candidates(n, x, (last < limit) ? last : limit, increments, increment_count, current_increment, NULL, 0));
+    }));
+}
+
+/* this function calculates the increments for n and stores the first
+ * candidate in start_number and the index of its increment in
+ * current_increment */
+template<typename number> static void build_wheel(const number &n, const number &base, const digit_counter &steps, vector<uint32_t> &increments, number &start_number, uint64_t &current_increment)
+{
+    vector<number> possible_factor_residuals;
+
+    find_possible_factor_residuals<number>(n, 0, possible_factor_residuals, base, 0, 0, steps, 0, 1);
+
+    sort(possible_factor_residuals.begin(), possible_factor_residuals.end());
+
+    possible_factor_residuals.erase(unique(possible_factor_residuals.begin(), possible_factor_residuals.end()), possible_factor_residuals.end());
+
+    for(typename vector<number>::size_type i = 0;i < possible_factor_residuals.size();i++)
+    {
+        number increment = (possible_factor_residuals[(i+1) % possible_factor_residuals.size()] % base + base - possible_factor_residuals[i] % base) % base;
+
+        /* increment < base < 2^32 */
+        increments.push_back(static_cast<uint32_t>(to_digit(increment)));
+    }
+
+    assert(increments.size() == possible_factor_residuals.size());
+
+    current_increment = 0;
+
+    while(current_increment < possible_factor_residuals.size() && possible_factor_residuals[current_increment] < 2)
+    {
+        current_increment++;
+    }
+
+#if DEBUG
+    for(typename vector<number>::size_type i=0;i < possible_factor_residuals.size();i++)
+    {
+        cout << "possible factor residual: " << possible_factor_residuals[i] << endl;
+        cout << "increment: " << increments[i] << endl;
+    }
+#endif
+
+#if DEBUG
+    cout << "calculated increments." << endl;
+#endif
+
+    if(current_increment < possible_factor_residuals.size())
+    {
+        start_number = possible_factor_residuals[current_increment];
+    }
+    /* this happens if n == 1 */
+    else
+    {
+        start_number = 2;
+        current_increment = 0;
+    }
+}
+
+/* the increments only depend on n mod base^steps if the search for the
+ * residuals is never cut off by a * b > n, i.e. if (base^steps - 1)^2 <= n.
+ * this function returns true and stores base^steps in modulus if this holds
+ * and the wheel can be cached. */
+template<typename number> static bool wheel_is_cacheable(const number &n, const number &base, const digit_counter &steps, uint64_t &modulus)
+{
+    mpz_class m = my_pow(to_mpz(base), steps);
+
+    if(bit_length(m) > 64 || (m - 1) * (m - 1) > to_mpz(n))
+    {
+        return false;
+    }
+
+    modulus = from_mpz<uint64_t>(m);
+
+    return true;
+}
+
+/* this function parses the comma separated list of bases given as
+ * -o bases=... */
+static vector<uint64_t> parse_bases(const string &list)
+{
+    vector<uint64_t> bases;
+    istringstream stream(list);
+    string base;
+
+    while(getline(stream, base, ','))
+    {
+        bases.push_back(strtoull(base.c_str(), NULL, 10));
+    }
+
+    return bases;
+}
+
+/* this function builds one wheel for several bases. the residuals which the
+ * digit equation allows for a factor are calculated for every base (modulo
+ * base^steps) and combined by the chinese remainder theorem into the
+ * residues modulo the product of the base^steps which pass the test of every
+ * base. the moduli have to be pairwise coprime and their product has to be
+ * below 2^32, otherwise (or if the wheel would get larger than
+ * MAX_CRT_WHEEL) it returns false. */
+template<typename number> static bool build_crt_wheel(const number &n, const vector<uint64_t> &bases, const digit_counter &steps, vector<uint32_t> &increments, number &start_number, uint64_t &current_increment)
+{
+    vector<uint64_t> residues(1, 0);
+    uint64_t modulus = 1;
+
+    for(vector<uint64_t>::size_type i = 0;i < bases.size();i++)
+    {
+        uint64_t m = 1;
+
+        if(bases[i] < 2) return false;
+
+        for(digit_counter k = 0;k < steps;k++)
+        {
+            if(m > (UINT32_MAX / modulus) / bases[i]) return false;
+            m *= bases[i];
+        }
+
+        pair<bool, uint64_t> inverse = find_inverse<uint64_t>(modulus % m, m);
+
+        if(m > 1 && !inverse.first) return false;
+
+        /* the residuals of this base modulo m */
+        vector<number> possible_factor_residuals;
+        vector<uint64_t> allowed;
+
+        find_possible_factor_residuals<number>(n, 0, possible_factor_residuals, static_cast<number>(bases[i]), 0, 0, steps, 0, 1);
+
+        for(typename vector<number>::size_type j = 0;j < possible_factor_residuals.size();j++)
+        {
+            allowed.push_back(from_mpz<uint64_t>(to_mpz(possible_factor_residuals[j] % static_cast<number>(m))));
+        }
+
+        sort(allowed.begin(), allowed.end());
+        allowed.erase(unique(allowed.begin(), allowed.end()), allowed.end());
+
+        if(residues.size() * allowed.size() > MAX_CRT_WHEEL) return false;
+
+        /* z = x mod modulus and z = y mod m */
+        vector<uint64_t> combined;
+
+        for(vector<uint64_t>::size_type x = 0;x < residues.size();x++)
+        {
+            for(vector<uint64_t>::size_type y = 0;y < allowed.size();y++)
+            {
+                uint64_t t = (allowed[y] + m - residues[x] % m) % m * inverse.second % m;
+                combined.push_back(residues[x] + modulus * t);
+            }
+        }
+
+        residues.swap(combined);
+        modulus *= m;
+    }
+
+    if(residues.empty()) return false;
+
+    sort(residues.begin(), residues.end());
+
+#if DEBUG
+    cout << "the wheel modulo " << modulus << " keeps " << residues.size() << " residues." << endl;
+#endif
+
+    for(vector<uint64_t>::size_type i = 0;i + 1 < residues.size();i++)
+    {
+        increments.push_back(residues[i + 1] - residues[i]);
+    }
+
+    increments.push_back(residues[0] + modulus - residues.back());
+
+    /* 0 and 1 are no candidates */
+    current_increment = 0;
+
+    while(current_increment < residues.size() && residues[current_increment] < 2)
+    {
+        current_increment++;
+    }
+
+    if(current_increment < residues.size())
+    {
+        start_number = residues[current_increment];
+    }
+    else
+    {
+        current_increment = 0;
+        start_number = residues[0] + modulus;
+    }
+
+    return true;
+}
+
+/* this function returns the number of residues x modulo p^e for which
+ * x * y = n modulo p^e has a solution y, i.e. for which gcd(x, p^e) divides
+ * n. p divides n v times. */
+static double solvable_residues(const uint64_t &p, const digit_counter &e, const digit_counter &v)
+{
+    double power = pow(static_cast<double>(p), static_cast<double>(e));
+
+    return (v >= e) ? power : power - pow(static_cast<double>(p), static_cast<double>(e - v - 1));
+}
+
+/* this function chooses base (at most max_base) and steps for the wheel of n
+ * (--auto-base). the
+ * wheel keeps the residues x modulo base^steps for which x * y = n has a
+ * solution modulo base^steps, their number follows from how often the primes
+ * of base divide n. building the wheel tries base^2 digit pairs for every
+ * residue modulo base^(steps - 1), each costing about 2 * steps + 1
+ * divisions, and the trial division tries sqrt(n) * residues / base^steps
+ * candidates. the base and steps with the smallest sum are chosen. */
+template<typename number> static void choose_wheel(const number &n, const number &max_base, number &base, digit_counter &steps)
+{
+    double log_root = natural_log(to_mpz(n)) / 2;
+    double best = HUGE_VAL;
+
+    for(size_t i = 0;i < sizeof(wheel_base_candidates) / sizeof(wheel_base_candidates[0]);i++)
+    {
+        uint64_t b = wheel_base_candidates[i];
+        /* the prime powers p^e of b and how often p divides n */
+        vector<uint64_t> primes;
+        vector<digit_counter> exponents;
+        vector<digit_counter> valuations;
+        uint64_t rest = b;
+
+        if(b > max_base)
+        {
+            continue;
+        }
+
+        for(uint64_t p = 2;rest > 1;p++)
+        {
+            if(rest % p != 0) continue;
+
+            number m = n;
+
+            primes.push_back(p);
+            exponents.push_back(0);
+            valuations.push_back(0);
+
+            while(rest % p == 0)
+            {
+                rest /= p;
+                exponents.back()++;
+            }
+
+            /* p^64 > base^steps */
+            while(valuations.back() < 64 && m % p == 0)
+            {
+                m /= p;
+                valuations.back()++;
+            }
+        }
+
+        /* the residues modulo b^(s - 1) and b^s */
+        double residues = 1;
+        uint64_t modulus = 1;
+
+        for(digit_counter s = 1;modulus <= UINT32_MAX / b;s++)
+        {
+            double next_residues = 1;
+
+            modulus *= b;
+
+            for(vector<uint64_t>::size_type j = 0;j < primes.size();j++)
+            {
+                next_residues *= solvable_residues(primes[j], exponents[j] * s, valuations[j]);
+            }
+
+            if(next_residues > MAX_AUTO_WHEEL)
+            {
+                break;
+            }
+
+            double build = log(residues * b * b * (2 * s + 1));
+            double trial = log_root + log(next_residues) - log(static_cast<double>(modulus));
+            /* the logarithm of the sum of both */
+            double estimate = max(build, trial) + log1p(exp(min(build, trial) - max(build, trial)));
+
+#if DEBUG
+            cout << "base " << b << " steps " << s << ": " << next_residues << " residues, estimated " << exp(estimate) << " divisions." << endl;
+#endif
+
+            if(estimate < best)
+            {
+                best = estimate;
+                base = b;
+                steps = s;
+            }
+
+            residues = next_residues;
+        }
+    }
+
+#if DEBUG
+    cout << "using the base " << base << " and steps " << steps << "." << endl;
+#endif
+}
+
+/* this function continues the trial division from the checkpoint state
+ * (see save_position), it stores the candidate and the index of its
+ * increment in start_number and current_increment. the candidate has to be
+ * on the wheel of increments behind start_number, otherwise the checkpoint is
+ * rejected and nothing is changed. */
+template<typename number> static void resume_position(search_checkpoint *checkpoint, const string &state, const uint32_t *increments, const uint64_t &increment_count, number &start_number, uint64_t &current_increment)
+{
+    checkpoint_reader reader(state);
+    mpz_class x = reader.get_number();
+    uint64_t resumed_increment = reader.get();
+    uint64_t resumed_count = reader.get();
+
+    if(!reader.good() || !reader.at_end() || resumed_count != increment_count || resumed_increment >= increment_count || x < to_mpz(start_number))
+    {
+        checkpoint->reject("other wheel");
+        return;
+    }
+
+    /* the distance from start_number to a candidate with the increment
+     * resumed_increment is the sum of the increments before it modulo the
+     * sum of all increments */
+    mpz_class period = 0;
+    mpz_class distance = 0;
+
+    for(uint64_t i = 0;i < increment_count;i++)
+    {
+        period += increments[i];
+    }
+
+    for(uint64_t i = current_increment;i != resumed_increment;i = (i + 1 < increment_count) ? i + 1 : 0)
+    {
+        distance += increments[i];
+    }
+
+    if((x - to_mpz(start_number)) % period != distance % period)
+    {
+        checkpoint->reject("other wheel");
+        return;
+    }
+
+    start_number = from_mpz<number>(x);
+    current_increment = resumed_increment;
+}
+
+/* this function returns the number of bits the wheel of base^steps needs.
+ * the search for the residuals multiplies two residues below base^steps, the
+ * candidates go up to the square root of n plus a block of at most
+ * BLOCK_CANDIDATES whole cycles for every thread. the combined wheel of
+ * bases=... has a modulus below 2^32, so it fits into 64 bits anyway. */
+static unsigned int wheel_bits(const mpz_class &n, const mpz_class &base, const digit_counter &steps)
+{
+    unsigned int modulus_bits = steps * bit_length(base);
+
+    return max(bit_length(n) + 1, max(2 * modulus_bits, modulus_bits + 32));
+}
+
+/* this function chooses the wheel for --auto-base, see choose_base_function */
+template<typename number> static bool choose_base(const number &n, const number &max_base, number &base, digit_counter &steps, const factorise_options &options, pair<number, number> &factors)
+{
+    // not used
+    (void)factors;
+
+    /* the combined wheel of bases=... doesn't depend on the base */
+    if(options.parameters.count("bases") != 0)
+    {
+        base = max_base;
+        return false;
+    }
+
+    base = 2;
+    steps = 1;
+
+    /* a resumed search keeps the wheel of its checkpoint */
+    if(!resumed_base(options, "enhanced_trial_division", n, max_base, base, steps))
+    {
+        choose_wheel(n, max_base, base, steps);
+    }
+
+    return false;
+}
+
+template<typename number> static pair<number, number> factorise(const number &n, const number &base, const digit_counter &steps, const factorise_options &options)
+{
+    vector<uint32_t> local_increments;
+    const uint32_t *increments;
+    uint64_t increment_count;
+    uint64_t current_increment = 0;
+    number start_number;
+    map<string, string>::const_iterator cache = options.parameters.find("wheel-cache");
+    map<string, string>::const_iterator bases = options.parameters.find("bases");
+    uint64_t modulus;
+
+    /* a prime would make the search run to exhaustion */
+    if(is_prime(n))
+    {
+        return make_pair(1, n);
+    }
+
+    if(bases != options.parameters.end() && build_crt_wheel(n, parse_bases(bases->second), steps, local_increments, start_number, current_increment))
+    {
+#if DEBUG
+        cout << "using the combined wheel of the bases " << bases->second << "." << endl;
+#endif
+    }
+    else if(n % base == 0 && steps == 1)
+    {
+#if DEBUG
+        cout << "hint: n modulo base == 0 and steps == 1, cannot skip numbers, try another base!" << endl;
+#endif
+        start_number = 2;
+        local_increments.push_back(1);
+    }
+    else if(is_prime(base))
+    {
+#if DEBUG
+        cout << "hint: base is prime, cannot skip numbers, try another base!" << endl;
+#endif
+        start_number = 2;
+        local_increments.push_back(1);
+    }
+    else if(cache != options.parameters.end() && wheel_is_cacheable(n, base, steps, modulus))
+    {
+        uint64_t residue = from_mpz<uint64_t>(to_mpz(n % from_mpz<number>(to_mpz(modulus))));
+        wheel cached;
+
+        if(load_wheel(cache->second, to_digit(base), steps, residue, cached))
+        {
+#if DEBUG
+            cout << "using the cached increments." << endl;
+#endif
+            increments = cached.increments;
+            increment_count = cached.count;
+            current_increment = cached.start_index;
+            start_number = from_mpz<number>(to_mpz(cached.start));
+
+            goto trial_division;
+        }
+
+        build_wheel(n, base, steps, local_increments, start_number, current_increment);
+        store_wheel(cache->second, to_digit(base), steps, residue, from_mpz<uint64_t>(to_mpz(start_number)), current_increment, local_increments);
+    }
+    else
+    {
+        build_wheel(n, base, steps, local_increments, start_number, current_increment);
+    }
+
+    increments = local_increments.data();
+    increment_count = local_increments.size();
+
+trial_division:
+    number limit = my_sqrt(n);
+    number x;
+    string state;
+
+    if(options.checkpoint != NULL && options.checkpoint->start("enhanced_trial_division", to_mpz(n), to_mpz(base), steps, state))
+    {
+        resume_position(options.checkpoint, state, increments, increment_count, start_number, current_increment);
+    }
+
+    if(options.processes > 0)
+    {
+        x = sharded_trial_division(n, start_number, limit, increments, increment_count, current_increment, options.processes);
+    }
+    else if(worker_count(options.threads) > 1 || options.checkpoint != NULL || options.token != NULL)
+    {
+        x = parallel_trial_division(n, start_number, limit, increments, increment_count, current_increment, worker_count(options.threads), options.checkpoint, options.token);
+    }
+    else
+    {
+        x = try_candidates(n, start_number, limit, increments, increment_count, current_increment, NULL, 0);
+    }
+
+    if(x != 0)
+    {
+        return make_pair(x, n / x);
+    }
+
+    return make_pair(1, n);
+}
+
+DEFINE_ENGINE(enhanced_trial_division_engine, "enhanced", factorise, choose_base, wheel_bits, false, false, true, true, parameters_help)
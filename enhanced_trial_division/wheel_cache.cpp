@@ -0,0 +1,151 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <tuple>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "wheel_cache.h"
+
+using namespace std;
+
+#define WHEEL_MAGIC "ETDWHEL1"
+
+/* the layout of a cache file, the increments (uint32_t) follow the header */
+struct wheel_header
+{
+    char magic[8];
+    uint64_t base;
+    uint64_t steps;
+    uint64_t residue;
+    uint64_t start;
+    uint64_t start_index;
+    uint64_t count;
+};
+
+typedef tuple<string, uint64_t, uint64_t, uint64_t> wheel_key;
+
+/* the wheels which were mapped by this process */
+static map<wheel_key, wheel> mapped_wheels;
+static mutex mapped_wheels_lock;
+
+static string wheel_path(const string &directory, const uint64_t &base, const uint64_t &steps, const uint64_t &residue)
+{
+    ostringstream path;
+    path << directory << "/wheel-" << base << "-" << steps << "-" << residue;
+    return path.str();
+}
+
+bool load_wheel(const string &directory, const uint64_t &base, const uint64_t &steps, const uint64_t &residue, wheel &result)
+{
+    wheel_key key(directory, base, steps, residue);
+    lock_guard<mutex> lock(mapped_wheels_lock);
+    map<wheel_key, wheel>::const_iterator it = mapped_wheels.find(key);
+
+    if(it != mapped_wheels.end())
+    {
+        result = it->second;
+        return true;
+    }
+
+    int fd = open(wheel_path(directory, base, steps, residue).c_str(), O_RDONLY);
+    struct stat info;
+
+    if(fd < 0)
+    {
+        return false;
+    }
+
+    if(fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(wheel_header))
+    {
+        close(fd);
+        return false;
+    }
+
+    void *memory = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(memory == MAP_FAILED)
+    {
+        return false;
+    }
+
+    const wheel_header *header = static_cast<const wheel_header *>(memory);
+
+    /* a file of another version or a damaged one is ignored */
+    if(memcmp(header->magic, WHEEL_MAGIC, sizeof(header->magic)) != 0 || header->base != base || header->steps != steps || header->residue != residue
+        || header->count == 0 || header->start_index >= header->count
+        || static_cast<uint64_t>(info.st_size) != sizeof(wheel_header) + header->count * sizeof(uint32_t))
+    {
+        munmap(memory, info.st_size);
+        return false;
+    }
+
+    result.start = header->start;
+    result.start_index = header->start_index;
+    result.count = header->count;
+    result.increments = reinterpret_cast<const uint32_t *>(header + 1);
+
+    mapped_wheels[key] = result;
+
+    return true;
+}
+
+bool store_wheel(const string &directory, const uint64_t &base, const uint64_t &steps, const uint64_t &residue, const uint64_t &start, const uint64_t &start_index, const vector<uint32_t> &increments)
+{
+    wheel_header header;
+    string path = wheel_path(directory, base, steps, residue);
+    ostringstream temporary;
+
+    memcpy(header.magic, WHEEL_MAGIC, sizeof(header.magic));
+    header.base = base;
+    header.steps = steps;
+    header.residue = residue;
+    header.start = start;
+    header.start_index = start_index;
+    header.count = increments.size();
+
+    mkdir(directory.c_str(), 0777);
+
+    /* readers never see a partially written file */
+    temporary << path << ".tmp." << getpid() << "." << this_thread::get_id();
+
+    ofstream file(temporary.str().c_str(), ios::binary);
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(increments.data()), increments.size() * sizeof(uint32_t));
+    file.close();
+
+    if(!file || rename(temporary.str().c_str(), path.c_str()) != 0)
+    {
+        unlink(temporary.str().c_str());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,49 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __WHEEL_CACHE_H__
+#define __WHEEL_CACHE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* the increments of enhanced trial division for one (base, steps, n mod
+ * base^steps). the candidates are start, start + increments[start_index],
+ * ... (the increments are used cyclically). */
+struct wheel
+{
+    uint64_t start;
+    uint64_t start_index;
+    uint64_t count;
+    const uint32_t *increments;
+};
+
+/* this function looks up the wheel for (base, steps, residue) in the cache
+ * directory directory. the file is mapped into memory and stays mapped until
+ * the program ends, so the wheel can be used by all threads. it returns false
+ * if the wheel is not cached. */
+bool load_wheel(const std::string &directory, const uint64_t &base, const uint64_t &steps, const uint64_t &residue, wheel &result);
+
+/* this function writes the wheel for (base, steps, residue) to the cache
+ * directory directory (which is created if necessary) */
+bool store_wheel(const std::string &directory, const uint64_t &base, const uint64_t &steps, const uint64_t &residue, const uint64_t &start, const uint64_t &start_index, const std::vector<uint32_t> &increments);
+
+#endif /* __WHEEL_CACHE_H__ */
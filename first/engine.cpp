@@ -0,0 +1,191 @@
+/*
+ *  A slow but simple integer factorisation algorithm.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider (idea, implementation)
+ *  Copyright (C) 2015 Lorenz Oberhammer (proofs)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <vector>
+#include <tuple>
+
+#include "../common/auto_base.h"
+#include "../common/common.h"
+#include "../common/engine.h"
+#include "../common/parallel_search.h"
+#include "../common/search_stats.h"
+
+using namespace std;
+
+/* a pair of digits costs a product and a remainder like a child of a node,
+ * see estimated_work */
+#define PAIR_COST 1.0
+
+template<typename number> static tuple<number, number, bool> find_next_digits(const number &n, const digit_counter &current_digit, const number &first_factor_so_far, const number &second_factor_so_far, const number &base, const number &current_base, const number &previous_base, search_control<number> *control)
+{
+    number a;
+    number b;
+    number d;
+    number product;
+    number product_mod;
+    number factor;
+    factor_bound bound;
+    /* (a, b) and (b, a) span mirrored subtrees, so only the pair whose
+     * lowest differing digit is smaller in a is searched */
+    bool equal_so_far = first_factor_so_far == second_factor_so_far;
+    /* a resumed search continues at these digits in the node on its path */
+    digit resumed_first_factor_digit = 0;
+    digit resumed_second_factor_digit = 0;
+    bool resumed;
+
+    if(control != NULL && control->cancelled())
+    {
+        return make_tuple(1, n, false);
+    }
+
+    STATS_NODE(current_digit);
+
+    resumed = control != NULL && control->enter(current_digit, resumed_first_factor_digit, resumed_second_factor_digit);
+
+    d = n % current_base;
+
+    for(number first_factor_digit = resumed ? number(resumed_first_factor_digit) : number(0);first_factor_digit < base;first_factor_digit++)
+    {
+        for(number second_factor_digit = (resumed && first_factor_digit == resumed_first_factor_digit) ? number(resumed_second_factor_digit) : equal_so_far ? first_factor_digit : 0;second_factor_digit < base;second_factor_digit++)
+        {
+            a = first_factor_so_far;
+            b = second_factor_so_far;
+            set_digit(a, first_factor_digit, previous_base);
+            set_digit(b, second_factor_digit, previous_base);
+
+            product = a * b;
+            product_mod = product % current_base;
+
+            if(product > n)
+            {
+                STATS_COUNT(current_digit, product_prunes);
+                break;
+            }
+
+            if(d != product_mod)
+            {
+                STATS_COUNT(current_digit, equation_rejections);
+            }
+
+            if(d == product_mod && product != n)
+            {
+                bound = bound_factors(n, a, b, current_base, factor);
+
+                if(bound == BOUND_FACTOR)
+                {
+                    return make_tuple(factor, n / factor, true);
+                }
+
+                if(bound == BOUND_EMPTY)
+                {
+                    STATS_COUNT(current_digit, interval_prunes);
+                    continue;
+                }
+
+                STATS_COUNT(current_digit, children);
+
+                if(control != NULL && control->split(current_digit + 1))
+                {
+                    control->add_subtree(search_node<number>(current_digit + 1, a, b, current_base * base, current_base, 0));
+                }
+                else
+                {
+                    if(control != NULL) control->descend(current_digit, first_factor_digit, second_factor_digit);
+
+                    tuple<number, number, bool> factors = find_next_digits<number>(n, current_digit + 1, a, b, base, current_base * base, current_base, control);
+                    if(get<2>(factors)) return factors;
+                }
+            }
+
+            if(product == n)
+            {
+                /* don't use trivial factorisations */
+                if(a != 1 && b != 1)
+                {
+                    return make_tuple(a, b, true);
+                }
+            }
+        }
+    }
+
+    return make_tuple(1, n, false);
+}
+
+/* this function chooses the base for --auto-base, see choose_base_function */
+template<typename number> static bool choose_base(const number &n, const number &max_base, number &base, digit_counter &steps, const factorise_options &options, pair<number, number> &factors)
+{
+    digit_counter resumed_steps;
+
+    // not used
+    (void)steps;
+
+    base = max_base;
+
+    /* a prime would make the probes run to exhaustion */
+    if(is_prime(n))
+    {
+        factors = make_pair(1, n);
+        return true;
+    }
+
+    /* n = 0 has no digits, a resumed search keeps the base of its
+     * checkpoint */
+    if(n == 0 || resumed_base(options, "first", n, max_base, base, resumed_steps))
+    {
+        return false;
+    }
+
+    tuple<number, number, bool> r = choose_digit_base<number>(n, max_base, PAIR_COST, base, [&](const number &probe_base, search_control<number> *control)
+    {
+        return find_next_digits<number>(n, 0, 0, 0, probe_base, probe_base, 1, control);
+    });
+
+    factors = make_pair(get<0>(r), get<1>(r));
+
+    return get<2>(r);
+}
+
+template<typename number> static pair<number, number> factorise(const number &n, const number &base, const digit_counter &steps, const factorise_options &options)
+{
+    // not used
+    (void)steps;
+
+    /* a prime would make the search run to exhaustion */
+    if(is_prime(n))
+    {
+        return make_pair(1, n);
+    }
+
+    if(n != 0)
+    {
+        tuple<number, number, bool> r = run_digit_search<number>(n, base, "first", options, [&](const search_node<number> &node, search_control<number> *control)
+        {
+            return find_next_digits(n, node.current_digit, node.first_factor_so_far, node.second_factor_so_far, base, node.current_base, node.previous_base, control);
+        });
+
+        return make_pair(get<0>(r), get<1>(r));
+    }
+    else
+    {
+        return make_pair(1, 0);
+    }
+}
+
+DEFINE_ENGINE(first_engine, "first", factorise, choose_base, digit_search_bits, false, false, false, false, NULL)
@@ -17,80 +17,10 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <iostream>
-#include <vector>
-#include <tuple>
-
 #include "../common/common.h"
-
-using namespace std;
-
-tuple<number, number, bool> find_next_digits(const number &n, const digit_counter &current_digit, const number &first_factor_so_far, const number &second_factor_so_far, const number &base, const number &current_base, const number &previous_base)
-{
-    number a;
-    number b;
-    number d;
-    number product;
-    number product_mod;
-
-    d = n % current_base;
-
-    for(number first_factor_digit = 0;first_factor_digit < base;first_factor_digit++)
-    {
-        for(number second_factor_digit = 0;second_factor_digit < base;second_factor_digit++)
-        {
-            a = first_factor_so_far;
-            b = second_factor_so_far;
-            set_digit(a, first_factor_digit, previous_base);
-            set_digit(b, second_factor_digit, previous_base);
-
-            product = a * b;
-            product_mod = product % current_base;
-
-            if(product > n)
-            {
-                break;
-            }
-
-            if(d == product_mod && product != n)
-            {
-                tuple<number, number, bool> factors = find_next_digits(n, current_digit + 1, a, b, base, current_base * base, current_base);
-                if(get<2>(factors)) return move(factors);
-            }
-
-            if(product == n)
-            {
-                /* don't use trivial factorisations */
-                if(a != 1 && b != 1)
-                {
-                    return make_tuple(a, b, true);
-                }
-            }
-        }
-    }
-
-    return make_tuple(1, n, false);
-}
-
-pair<number, number> factorise(const number &n, const number &base, const digit_counter &steps)
-{
-    // not used
-    (void)steps;
-
-    if(n != 0)
-    {
-        tuple<number, number, bool> r = find_next_digits(n, 0, 0, 0, base, base, 1);
-
-        return make_pair(get<0>(r), get<1>(r));
-    }
-    else
-    {
-        return make_pair(1, 0);
-    }
-}
+#include "../common/engine.h"
 
 int main(int argc, char *argv[])
 {
-    return common_main(argc, argv, false, false, false);
+    return common_main(argc, argv, first_engine);
 }
-
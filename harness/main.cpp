@@ -0,0 +1,431 @@
+/*
+ * Differential test and benchmark of all factorisation algorithms.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <getopt.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "../common/auto_base.h"
+#include "../common/common.h"
+#include "../common/engine.h"
+#include "../common/thread_pool.h"
+
+using namespace std;
+
+/* an input together with what the engines have to return for it */
+struct test_input
+{
+    const char *kind;
+    mpz_class n;
+    bool prime;
+    mpz_class smallest_factor;
+};
+
+/* the result of one engine on one input */
+struct test_result
+{
+    double seconds;
+    bool correct;
+    pair<mpz_class, mpz_class> factors;
+};
+
+void harness_usage(char *name)
+{
+    cout << "usage:" << endl;
+    cout << name << " [options]" << endl;
+    cout << "runs all algorithms on random numbers, semiprimes and primes, checks their" << endl;
+    cout << "results and writes the throughput and latencies of every algorithm as json." << endl;
+    cout << "options:" << endl;
+    cout << "\t-j, --threads threads" << endl;
+    cout << "\t\tIs the number of threads the runs are spread over, 0 means one" << endl;
+    cout << "\t\tper hardware thread. If not specified threads = 1 will be used." << endl;
+    cout << "\t-n, --count count" << endl;
+    cout << "\t\tIs the number of inputs of each kind, default 100." << endl;
+    cout << "\t-b, --bits bits" << endl;
+    cout << "\t\tIs the size of the inputs in bits (at least 4), default 24." << endl;
+    cout << "\t-s, --seed seed" << endl;
+    cout << "\t\tSeeds the random number generator, default 1." << endl;
+    cout << "\t-e, --engines engine,..." << endl;
+    cout << "\t\tSelects the algorithms by their names in the registry, default all" << endl;
+    cout << "\t\tof them:";
+    for(size_t i = 0;i < engine_count;i++)
+    {
+        cout << " " << engines[i]->name;
+    }
+    cout << "." << endl;
+    cout << "\t--base base, --steps steps" << endl;
+    cout << "\t\tAre passed to the algorithms, default 2 and 1." << endl;
+    cout << "\t--auto-base" << endl;
+    cout << "\t\tLets the algorithms choose the base (and steps) instead." << endl;
+    cout << "\t--check-auto-base" << endl;
+    cout << "\t\tChecks the bases --auto-base chooses for inputs with known run" << endl;
+    cout << "\t\ttimes instead." << endl;
+    cout << "\t--number-type type" << endl;
+    cout << "\t\tForces the number type (uint64, uint128, uint256 or gmp)." << endl;
+}
+
+/* this function returns a random number with exactly bits bits */
+static mpz_class random_bits(gmp_randstate_t state, unsigned int bits)
+{
+    mpz_class low = 1;
+
+    low <<= bits - 1;
+
+    return my_rand(state, low, 2 * low - 1);
+}
+
+static mpz_class next_prime(const mpz_class &x)
+{
+    mpz_class p;
+    mpz_nextprime(p.get_mpz_t(), x.get_mpz_t());
+    return p;
+}
+
+/* this function returns the smallest prime factor of n > 1. it only uses
+ * gmp, so that the reference doesn't share code with the algorithms */
+static mpz_class reference_smallest_factor(const mpz_class &n)
+{
+    if(mpz_probab_prime_p(n.get_mpz_t(), 25) != 0)
+    {
+        return n;
+    }
+
+    if(mpz_divisible_ui_p(n.get_mpz_t(), 2) != 0)
+    {
+        return 2;
+    }
+
+    for(unsigned long int d = 3;;d += 2)
+    {
+        if(mpz_divisible_ui_p(n.get_mpz_t(), d) != 0)
+        {
+            return d;
+        }
+    }
+}
+
+/* this function creates count random numbers, semiprimes and primes of
+ * about bits bits together with their reference results */
+static vector<test_input> create_inputs(unsigned long int seed, unsigned long int count, unsigned int bits)
+{
+    vector<test_input> inputs;
+    gmp_randstate_t state;
+
+    gmp_randinit_default(state);
+    gmp_randseed_ui(state, seed);
+
+    for(unsigned long int i = 0;i < count;i++)
+    {
+        mpz_class p = next_prime(random_bits(state, bits / 2));
+        mpz_class q = next_prime(random_bits(state, bits - bits / 2));
+        mpz_class n = random_bits(state, bits);
+        mpz_class prime = next_prime(random_bits(state, bits));
+
+        inputs.push_back(test_input{"random", n, mpz_probab_prime_p(n.get_mpz_t(), 25) != 0, reference_smallest_factor(n)});
+        inputs.push_back(test_input{"semiprime", p * q, false, min(p, q)});
+        inputs.push_back(test_input{"prime", prime, true, prime});
+    }
+
+    gmp_randclear(state);
+
+    return inputs;
+}
+
+/* this function returns true if factors is a correct answer of e for input */
+static bool check_result(const factorisation_engine &e, const test_input &input, const pair<mpz_class, mpz_class> &factors)
+{
+    const mpz_class &a = factors.first, &b = factors.second;
+
+    if(input.prime)
+    {
+        return (a == 1 && b == input.n) || (a == input.n && b == 1);
+    }
+
+    if(a * b != input.n || a < 2 || b < 2)
+    {
+        return false;
+    }
+
+    return !e.smallest_factor || a == input.smallest_factor;
+}
+
+/* an input on which the slow bases (0 ends them) ran at least 10 times longer
+ * than the fastest base, measured with the release build. the time to the
+ * first factor also depends on where it lies in the search, which makes
+ * bases of about the same work differ by up to 5 times. */
+struct base_ranking
+{
+    const char *engine;
+    const char *n;
+    digit slow[sizeof(digit_base_candidates) / sizeof(digit_base_candidates[0])];
+};
+
+static const base_ranking base_rankings[] = {
+    {"first", "1000000016000000063", {10, 12, 16, 30}},
+    {"second", "1000000016000000063", {5, 12, 16, 30}},
+    {"third", "1000000016000000063", {16, 30}},
+};
+
+/* this function checks that --auto-base ranks the bases of base_rankings
+ * correctly, i.e. that it chooses none of the slow bases for any largest
+ * base it may choose. it returns the number of wrong choices. */
+static unsigned long int check_auto_base()
+{
+    unsigned long int checks = 0;
+    unsigned long int mismatches = 0;
+    factorise_options options;
+
+    options.auto_base = true;
+
+    for(size_t i = 0;i < sizeof(base_rankings) / sizeof(base_rankings[0]);i++)
+    {
+        const base_ranking &r = base_rankings[i];
+        const factorisation_engine *e = find_engine(r.engine);
+        mpz_class n(r.n);
+
+        for(size_t j = 0;j < sizeof(digit_base_candidates) / sizeof(digit_base_candidates[0]);j++)
+        {
+            mpz_class base = digit_base_candidates[j];
+            digit_counter steps = 1;
+            pair<mpz_class, mpz_class> factors;
+
+            if(e->choose_base(n, base, steps, options, factors))
+            {
+                continue;
+            }
+
+            checks++;
+
+            for(size_t k = 0;k < sizeof(r.slow) / sizeof(r.slow[0]) && r.slow[k] != 0;k++)
+            {
+                if(base == r.slow[k])
+                {
+                    mismatches++;
+                    cerr << "mismatch: " << e->name << " chose the slow base " << base << " for " << n << " with bases up to "
+                         << digit_base_candidates[j] << "." << endl;
+                }
+            }
+        }
+    }
+
+    cout << "{" << endl;
+    cout << "  \"auto_base_checks\": " << checks << "," << endl;
+    cout << "  \"mismatches\": " << mismatches << endl;
+    cout << "}" << endl;
+
+    return mismatches;
+}
+
+/* this function returns the q-quantile of the sorted values */
+static double quantile(const vector<double> &sorted, double q)
+{
+    vector<double>::size_type i = static_cast<vector<double>::size_type>(q * sorted.size());
+
+    return sorted[min(i, sorted.size() - 1)];
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int threads = 1;
+    unsigned long int count = 100;
+    unsigned int bits = 24;
+    unsigned long int seed = 1;
+    mpz_class base = 2;
+    digit_counter steps = 1;
+    const char *number_type = NULL;
+    factorise_options options;
+    vector<const factorisation_engine *> selected;
+    int opt;
+
+    static const struct option long_options[] = {
+        {"threads", required_argument, NULL, 'j'},
+        {"count", required_argument, NULL, 'n'},
+        {"bits", required_argument, NULL, 'b'},
+        {"seed", required_argument, NULL, 's'},
+        {"engines", required_argument, NULL, 'e'},
+        {"base", required_argument, NULL, 'B'},
+        {"steps", required_argument, NULL, 'S'},
+        {"number-type", required_argument, NULL, 'N'},
+        {"auto-base", no_argument, NULL, 'A'},
+        {"check-auto-base", no_argument, NULL, 'C'},
+        {NULL, 0, NULL, 0}
+    };
+
+    while((opt = getopt_long(argc, argv, "j:n:b:s:e:", long_options, NULL)) != -1)
+    {
+        switch(opt)
+        {
+            case 'j':
+                threads = strtoul(optarg, NULL, 10);
+                break;
+            case 'n':
+                count = strtoul(optarg, NULL, 10);
+                break;
+            case 'b':
+                bits = strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                seed = strtoul(optarg, NULL, 10);
+                break;
+            case 'e':
+            {
+                istringstream list(optarg);
+                string name;
+
+                while(getline(list, name, ','))
+                {
+                    const factorisation_engine *e = find_engine(name);
+
+                    if(e == NULL)
+                    {
+                        cerr << "unknown engine " << name << "." << endl;
+                        return -1;
+                    }
+
+                    selected.push_back(e);
+                }
+                break;
+            }
+            case 'B':
+                base = optarg;
+                break;
+            case 'S':
+                steps = strtoull(optarg, NULL, 10);
+                break;
+            case 'N':
+                number_type = optarg;
+                break;
+            case 'A':
+                options.auto_base = true;
+                break;
+            case 'C':
+                return (check_auto_base() == 0) ? 0 : -1;
+            default:
+                harness_usage(argv[0]);
+                return -1;
+        }
+    }
+
+    if(optind != argc || bits < 4 || count < 1 || base < 2 || base >= MAX_DIGIT_BASE || steps < 1)
+    {
+        harness_usage(argv[0]);
+        return -1;
+    }
+
+    if(selected.empty())
+    {
+        selected.assign(engines, engines + engine_count);
+    }
+
+    threads = worker_count(threads);
+
+    vector<test_input> inputs = create_inputs(seed, count, bits);
+    vector<test_result> results(selected.size() * inputs.size());
+    mutex report_lock;
+    unsigned long int mismatches = 0;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    /* task i runs engine i % engines on input i / engines, so that all
+     * threads run all engines */
+    run_work_stealing(results.size(), threads, [&](size_t task)
+    {
+        const factorisation_engine &e = *selected[task % selected.size()];
+        const test_input &input = inputs[task / selected.size()];
+        test_result &result = results[task];
+        /* the algorithms choose a base up to the largest one they may use */
+        mpz_class engine_base = options.auto_base ? mpz_class(e.use_steps ? MAX_AUTO_WHEEL_BASE : MAX_AUTO_DIGIT_BASE) : base;
+
+        chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+        result.factors = e.factorise_number(input.n, engine_base, steps, options, number_type);
+        result.seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+        result.correct = check_result(e, input, result.factors);
+
+        if(!result.correct)
+        {
+            lock_guard<mutex> lock(report_lock);
+
+            mismatches++;
+            cerr << "mismatch: " << e.name << " on the " << input.kind << " " << input.n << " returned "
+                 << result.factors.first << " * " << result.factors.second << "." << endl;
+        }
+    });
+
+    double wall_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << fixed << setprecision(3);
+    cout << "{" << endl;
+    cout << "  \"bits\": " << bits << "," << endl;
+    cout << "  \"inputs\": " << inputs.size() << "," << endl;
+    cout << "  \"seed\": " << seed << "," << endl;
+    cout << "  \"threads\": " << threads << "," << endl;
+    if(options.auto_base)
+    {
+        cout << "  \"base\": \"auto\"," << endl;
+    }
+    else
+    {
+        cout << "  \"base\": " << base << "," << endl;
+        cout << "  \"steps\": " << steps << "," << endl;
+    }
+    cout << "  \"wall_seconds\": " << wall_seconds << "," << endl;
+    cout << "  \"mismatches\": " << mismatches << "," << endl;
+    cout << "  \"engines\": {" << endl;
+
+    for(vector<const factorisation_engine *>::size_type i = 0;i < selected.size();i++)
+    {
+        vector<double> latencies;
+        double total = 0;
+        unsigned long int failures = 0;
+
+        for(vector<test_input>::size_type j = 0;j < inputs.size();j++)
+        {
+            const test_result &result = results[j * selected.size() + i];
+
+            latencies.push_back(1e6 * result.seconds);
+            total += result.seconds;
+            if(!result.correct) failures++;
+        }
+
+        sort(latencies.begin(), latencies.end());
+
+        cout << "    \"" << selected[i]->name << "\": {";
+        cout << "\"runs\": " << latencies.size() << ", ";
+        cout << "\"failures\": " << failures << ", ";
+        cout << "\"numbers_per_second\": " << ((total > 0) ? latencies.size() / total : 0) << ", ";
+        cout << "\"latency_us\": {";
+        cout << "\"mean\": " << 1e6 * total / latencies.size() << ", ";
+        cout << "\"p50\": " << quantile(latencies, 0.5) << ", ";
+        cout << "\"p90\": " << quantile(latencies, 0.9) << ", ";
+        cout << "\"p99\": " << quantile(latencies, 0.99) << ", ";
+        cout << "\"max\": " << latencies.back() << "}}";
+        cout << ((i + 1 < selected.size()) ? "," : "") << endl;
+    }
+
+    cout << "  }" << endl;
+    cout << "}" << endl;
+
+    return (mismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+/*
+ *  This file is part of https://github.com/krnlyng/integer_factorisation.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* libfactor (libfactor.a and libfactor.so, link with -lgmp -lgmpxx -pthread)
+ * contains all algorithms, a program factorises in-process with e.g.
+ *
+ *     const factorisation_engine *engine = find_engine("third");
+ *     std::pair<mpz_class, mpz_class> factors = engine->factorise_number(n);
+ *
+ * or with full_factorisation for the complete prime factorisation. results
+ * are remembered across runs by setting factorise_options::cache. */
+
+#ifndef __LIBFACTOR_H__
+#define __LIBFACTOR_H__
+
+#include "../common/cancellation.h"
+#include "../common/common.h"
+#include "../common/engine.h"
+#include "../common/factor_cache.h"
+#include "../common/full_factorisation.h"
+
+#endif /* __LIBFACTOR_H__ */
@@ -21,9 +21,12 @@
 #include <cmath>
 
 #include "../common/common.h"
+#include "../common/full_factorisation.h"
 
 using namespace std;
 
+typedef mpz_class number;
+
 struct ltbnjf_representation {
     ltbnjf_representation() : ltbnjf_representation(0,0) {}
     ltbnjf_representation(number i, number b)
@@ -48,35 +51,7 @@ void usage(char *name)
 /* factor, multiplicity */
 std::vector<std::pair<number, unsigned long int>> get_prime_factors(number n)
 {
-    std::vector<std::pair<number, unsigned long int>> result;
-
-    for(number i = 2; i <= n;i++)
-    {
-        if(n % i == 0)
-        {
-            if(is_prime(i))
-            {
-                unsigned long int multiplicity;
-                number tmp_number = n / i;
-
-                for(multiplicity = 1;;multiplicity++)
-                {
-                    if(tmp_number == 0) break;
-
-                    if(tmp_number % i != 0)
-                    {
-                        break;
-                    }
-
-                    tmp_number = tmp_number / i;
-                }
-
-                result.push_back(make_pair(i, multiplicity));
-            }
-        }
-    }
-
-    return result;
+    return full_factorisation(n, factorisation_budget(), 1);
 }
 
 std::vector<ltbnjf_representation> ltbnjf_factorise(ltbnjf_representation ltbnjf_number)
@@ -121,13 +96,8 @@ int main(int argc, char *argv[])
         return -1;
     }
 
-#if USE_GMP
     ltbnjf_number.base = argv[1];
     ltbnjf_number.index = argv[2];
-#else
-    ltbnjf_number.base = strtoull(argv[1], NULL, 10);
-    ltbnjf_number.index = strtoull(argv[2], NULL, 10);
-#endif
     
     if(ltbnjf_number.base < 2 || ltbnjf_number.index <= 0)
     {
@@ -0,0 +1,52 @@
+/*
+ * Pollard's rho algorithm with Brent's cycle detection.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider
+ *  Copyright (C) 2015 Lorenz Oberhammer
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <algorithm>
+
+#include "../common/cancellation.h"
+#include "../common/common.h"
+#include "../common/engine.h"
+#include "../common/pollard_rho.h"
+
+using namespace std;
+
+template<typename number> static pair<number, number> factorise(const number &n, const number &base, const digit_counter &steps, const factorise_options &options)
+{
+    // not used
+    (void)base;
+    (void)steps;
+
+    if(n < 4 || is_prime(n))
+    {
+        return make_pair(1, n);
+    }
+
+    number d = from_mpz<number>(pollard_rho(to_mpz(n), 0, options.token));
+
+    /* the budget ran out */
+    if(d == 0)
+    {
+        return make_pair(1, n);
+    }
+
+    return make_pair(min<number>(d, n / d), max<number>(d, n / d));
+}
+
+DEFINE_ENGINE(pollard_rho_engine, "rho", factorise, keep_base, square_root_bits, false, true, false, false, NULL)
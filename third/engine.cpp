@@ -0,0 +1,308 @@
+/*
+ *  Altered version of our second multiplication algorithm.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider (idea, implementation)
+ *  Copyright (C) 2015 Lorenz Oberhammer (proofs)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <vector>
+#include <tuple>
+
+#include "../common/auto_base.h"
+#include "../common/common.h"
+#include "../common/engine.h"
+#include "../common/parallel_search.h"
+#include "../common/search_stats.h"
+
+using namespace std;
+
+/* the second factor digits are solved for instead of tried, see
+ * estimated_work */
+#define PAIR_COST 0.0
+
+/* a node of the search together with the position of the digit loops in it.
+ * the frames of all depths are allocated once per search and reused, so the
+ * numbers in them keep their memory and the search needs no allocations. */
+template<typename number> struct search_frame
+{
+    number first_factor_so_far;
+    number second_factor_so_far;
+    number current_base;
+    number previous_base;
+    digit carry;
+    /* (a, b) and (b, a) span mirrored subtrees, so while the factors are
+     * equal only second factor digits >= first_factor_digit are searched */
+    bool equal_so_far;
+    /* first_factor_so_far with first_factor_digit set */
+    number a;
+    digit first_factor_digit;
+    digit next_first_factor_digit;
+    /* the next second factor digit to try for first_factor_digit, base if
+     * there is none left */
+    digit second_factor_digit;
+    /* the pair of digits at which a resumed search continues in this node,
+     * the first one is base in all other nodes */
+    digit resumed_first_factor_digit;
+    digit resumed_second_factor_digit;
+    digit a_0th_digit;
+    digit_class a_0th_class;
+    /* all terms of the digit equation except a_0 * b_current_digit */
+    wide_digit tmp;
+    search_node_clock clock;
+};
+
+/* this function returns the number of frames a search needs. a node at depth
+ * d > 0 has a * b = n (mod base^d) and a * b < n, so base^d <= n and d is
+ * smaller than the number of digits of n. */
+template<typename number> static digit_counter search_depth(const number &n, const number &base)
+{
+    return num_of_digits(n, base);
+}
+
+/* this function prepares frame f of a node at depth current_digit before
+ * its digits are searched */
+template<typename number> static inline void enter_frame(search_frame<number> &f, const digit_counter &current_digit, const digit_state &state, search_control<number> *control)
+{
+    f.next_first_factor_digit = 0;
+    f.second_factor_digit = state.base();
+    f.resumed_first_factor_digit = state.base();
+
+    if(control != NULL && control->enter(current_digit, f.resumed_first_factor_digit, f.resumed_second_factor_digit))
+    {
+        f.next_first_factor_digit = f.resumed_first_factor_digit;
+    }
+
+    STATS_NODE_START(f.clock, current_digit);
+}
+
+/* this function searches the tree below root depth first without recursion,
+ * the frames of the nodes on the current path are kept in frames */
+template<typename number> static tuple<number, number, bool> find_next_digits(const number &n, const search_node<number> &root, const number &base, digit_state &state, const digit_solver &solver, vector<search_frame<number>> &frames, search_control<number> *control)
+{
+    number b;
+    number product;
+    number factor;
+    factor_bound bound;
+    digit new_carry;
+    digit target;
+    digit lowest;
+    digit second_factor_digit;
+    /* frames[level] is the node at depth root.current_digit + level */
+    digit_counter level = 0;
+
+    if(control != NULL && control->cancelled())
+    {
+        return make_tuple(1, n, false);
+    }
+
+    frames[0].first_factor_so_far = root.first_factor_so_far;
+    frames[0].second_factor_so_far = root.second_factor_so_far;
+    frames[0].current_base = root.current_base;
+    frames[0].previous_base = root.previous_base;
+    frames[0].carry = root.carry;
+    frames[0].equal_so_far = root.first_factor_so_far == root.second_factor_so_far;
+    enter_frame(frames[0], root.current_digit, state, control);
+
+    for(;;)
+    {
+        search_frame<number> &f = frames[level];
+        digit_counter current_digit = root.current_digit + level;
+
+        if(f.second_factor_digit >= state.base())
+        {
+            if(f.next_first_factor_digit >= state.base())
+            {
+                /* the node is done, continue with its parent */
+                STATS_NODE_STOP(f.clock);
+
+                if(level == 0)
+                {
+                    return make_tuple(1, n, false);
+                }
+
+                level--;
+                continue;
+            }
+
+            f.first_factor_digit = f.next_first_factor_digit++;
+            f.a = f.first_factor_so_far;
+            set_digit(f.a, f.first_factor_digit, f.previous_base);
+            state.set_digits(current_digit, f.first_factor_digit, 0);
+            f.a_0th_digit = state.first_factor_digit(0);
+            f.a_0th_class = solver.get_class(f.a_0th_digit);
+
+            /* the second factor digit has to solve a_0 * b_current_digit = target */
+            f.tmp = state.convolution(current_digit, 1) + f.carry;
+            target = (state.n_digit(current_digit) + state.base() - static_cast<digit>(f.tmp % state.base())) % state.base();
+            /* a resumed node skips the pairs before the one it was in */
+            lowest = (f.first_factor_digit == f.resumed_first_factor_digit) ? f.resumed_second_factor_digit : f.equal_so_far ? f.first_factor_digit : 0;
+            f.second_factor_digit = solver.first_solution(f.a_0th_class, target, lowest);
+
+            if(f.second_factor_digit >= state.base())
+            {
+                STATS_COUNT(current_digit, inverse_failures);
+            }
+
+            continue;
+        }
+
+        second_factor_digit = f.second_factor_digit;
+        f.second_factor_digit += solver.step(f.a_0th_class);
+
+        state.set_digits(current_digit, f.first_factor_digit, second_factor_digit);
+        new_carry = static_cast<digit>((f.tmp + f.a_0th_digit * second_factor_digit) / state.base());
+
+        b = f.second_factor_so_far;
+        set_digit(b, second_factor_digit, f.previous_base);
+
+        product = f.a * b;
+
+        if(product > n)
+        {
+            /* the larger second factor digits give even larger products */
+            STATS_COUNT(current_digit, product_prunes);
+            f.second_factor_digit = state.base();
+            continue;
+        }
+
+        if(product == n)
+        {
+            /* don't use trivial factorisations */
+            if(f.a != 1 && b != 1)
+            {
+                for(digit_counter i = level + 1;i-- > 0;) STATS_NODE_STOP(frames[i].clock);
+
+                return make_tuple(f.a, b, true);
+            }
+
+            continue;
+        }
+
+        bound = bound_factors(n, f.a, b, f.current_base, factor);
+
+        if(bound == BOUND_FACTOR)
+        {
+            for(digit_counter i = level + 1;i-- > 0;) STATS_NODE_STOP(frames[i].clock);
+
+            return make_tuple(factor, n / factor, true);
+        }
+
+        if(bound == BOUND_EMPTY)
+        {
+            STATS_COUNT(current_digit, interval_prunes);
+            continue;
+        }
+
+        STATS_COUNT(current_digit, children);
+
+        if(control != NULL && control->split(current_digit + 1))
+        {
+            control->add_subtree(search_node<number>(current_digit + 1, f.a, b, f.current_base * base, f.current_base, new_carry));
+            continue;
+        }
+
+        if(control != NULL && control->cancelled())
+        {
+            for(digit_counter i = level + 1;i-- > 0;) STATS_NODE_STOP(frames[i].clock);
+
+            return make_tuple(1, n, false);
+        }
+
+        if(control != NULL) control->descend(current_digit, f.first_factor_digit, second_factor_digit);
+
+        search_frame<number> &child = frames[++level];
+
+        child.first_factor_so_far = f.a;
+        child.second_factor_so_far = b;
+        child.current_base = f.current_base * base;
+        child.previous_base = f.current_base;
+        child.carry = new_carry;
+        child.equal_so_far = f.a == b;
+        enter_frame(child, current_digit + 1, state, control);
+    }
+}
+
+/* this function chooses the base for --auto-base, see choose_base_function */
+template<typename number> static bool choose_base(const number &n, const number &max_base, number &base, digit_counter &steps, const factorise_options &options, pair<number, number> &factors)
+{
+    digit_counter resumed_steps;
+
+    // not used
+    (void)steps;
+
+    base = max_base;
+
+    /* a prime would make the probes run to exhaustion */
+    if(is_prime(n))
+    {
+        factors = make_pair(1, n);
+        return true;
+    }
+
+    /* n = 0 has no digits, a resumed search keeps the base of its
+     * checkpoint */
+    if(n == 0 || resumed_base(options, "third", n, max_base, base, resumed_steps))
+    {
+        return false;
+    }
+
+    tuple<number, number, bool> r = choose_digit_base<number>(n, max_base, PAIR_COST, base, [&](const number &probe_base, search_control<number> *control)
+    {
+        digit_state state(n, probe_base);
+        digit_solver probe_solver(to_digit(probe_base));
+        vector<search_frame<number>> frames(search_depth(n, probe_base));
+
+        return find_next_digits<number>(n, search_node<number>(0, 0, 0, probe_base, 1, 0), probe_base, state, probe_solver, frames, control);
+    });
+
+    factors = make_pair(get<0>(r), get<1>(r));
+
+    return get<2>(r);
+}
+
+template<typename number> static pair<number, number> factorise(const number &n, const number &base, const digit_counter &steps, const factorise_options &options)
+{
+    // not used
+    (void)steps;
+
+    /* a prime would make the search run to exhaustion */
+    if(is_prime(n))
+    {
+        return make_pair(1, n);
+    }
+
+    if(n != 0)
+    {
+        /* the solutions of the digit equation for all first factor digits */
+        digit_solver solver(to_digit(base));
+        tuple<number, number, bool> r = run_digit_search<number>(n, base, "third", options, [&](const search_node<number> &node, search_control<number> *control)
+        {
+            digit_state state(n, base);
+            vector<search_frame<number>> frames(search_depth(n, base));
+            state.load(node.current_digit, node.first_factor_so_far, node.second_factor_so_far);
+
+            return find_next_digits(n, node, base, state, solver, frames, control);
+        });
+
+        return make_pair(get<0>(r), get<1>(r));
+    }
+    else
+    {
+        return make_pair(1, 0);
+    }
+}
+
+DEFINE_ENGINE(third_engine, "third", factorise, choose_base, digit_search_bits, false, false, false, false, NULL)
@@ -17,139 +17,10 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <iostream>
-#include <vector>
-#include <tuple>
-
 #include "../common/common.h"
-
-using namespace std;
-
-tuple<number, number, bool> find_next_digits(const number &n, const digit_counter &current_digit, const number &first_factor_so_far, const number &second_factor_so_far, const number &base, const number &current_base, const number &previous_base, const number &carry)
-{
-    number a;
-    number b;
-    number product;
-    number tmp;
-    number new_carry;
-    number second_factor_digit;
-    number a_0th_digit;
-    pair<bool, number> inverse;
-
-    for(number first_factor_digit = 0;first_factor_digit < base;first_factor_digit++)
-    {
-        a = first_factor_so_far;
-        set_digit(a, first_factor_digit, previous_base);
-        a_0th_digit = get_digit(a, 1, base);
-
-        if(a_0th_digit == 0)
-        {
-            pair<bool, number> check;
-            for(second_factor_digit = 0;second_factor_digit < base;second_factor_digit++)
-            {
-                b = second_factor_so_far;
-                set_digit(b, second_factor_digit, previous_base);
-
-                check = check_if_new_digits_solve_digit_equation(n, a, b, carry, current_digit, base, previous_base);
-
-                if(check.first)
-                {
-                    product = a * b;
-
-                    if(product > n)
-                    {
-                        break;
-                    }
-
-                    if(product == n)
-                    {
-                        /* don't use trivial factorisations */
-                        if(a != 1 && b != 1)
-                        {
-                            return make_tuple(a, b, true);
-                        }
-                    }
-                    else
-                    {
-                        tuple<number, number, bool> factors = find_next_digits(n, current_digit + 1, a, b, base, current_base * base, current_base, check.second);
-                        if(get<2>(factors)) return move(factors);
-                    }
-                }
-            }
-        }
-        else
-        {
-            number lower_base = base;
-            number upper_base = previous_base / base;
-
-            b = second_factor_so_far;
-            tmp = first_factor_digit * get_digit(b, 1, base);
-
-            for(digit_counter i = 1;i < current_digit;i++)
-            {
-                tmp += get_digit(a, upper_base, base) * get_digit(b, lower_base, base);
-                lower_base *= base;
-                upper_base /= base;
-            }
-
-            inverse = find_inverse(a_0th_digit, base);
-    
-            if(inverse.first)
-            {
-                tmp += carry;
-                second_factor_digit = (inverse.second * (get_digit(n, previous_base, base) - tmp)) % base;
-
-                while(second_factor_digit < 0) second_factor_digit += base;
-
-                set_digit(b, second_factor_digit, previous_base);
-                new_carry = (tmp + a_0th_digit * second_factor_digit) / base;
-               
-                product = a * b;
-
-                if(product > n)
-                {
-                    continue;
-                }
-
-                if(product == n)
-                {
-                    /* don't use trivial factorisations */
-                    if(a != 1 && b != 1)
-                    {
-                        return make_tuple(a, b, true);
-                    }
-                }
-                else
-                {
-                    tuple<number, number, bool> factors = find_next_digits(n, current_digit + 1, a, b, base, current_base * base, current_base, new_carry);
-                    if(get<2>(factors)) return move(factors);
-                }
-            }
-        }
-    }
-
-    return make_tuple(1, n, false);
-}
-
-pair<number, number> factorise(const number &n, const number &base, const digit_counter &steps)
-{
-    // not used
-    (void)steps;
-
-    if(n != 0)
-    {
-        tuple<number, number, bool> r = find_next_digits(n, 0, 0, 0, base, base, 1, 0);
-
-        return make_pair(get<0>(r), get<1>(r));
-    }
-    else
-    {
-        return make_pair(1, 0);
-    }
-}
+#include "../common/engine.h"
 
 int main(int argc, char *argv[])
 {
-    return common_main(argc, argv, true, false, false);
+    return common_main(argc, argv, third_engine);
 }
-
@@ -0,0 +1,123 @@
+/*
+ * Trial division.
+ *  Copyright (C) 2015 Franz-Josef Anton Friedrich Haider (idea, implementation)
+ *  Copyright (C) 2015 Lorenz Oberhammer (proofs)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <iostream>
+
+#include "../common/cancellation.h"
+#include "../common/checkpoint.h"
+#include "../common/common.h"
+#include "../common/engine.h"
+#include "../common/prime_sieve.h"
+#include "../common/shards.h"
+
+using namespace std;
+
+template<typename number> static pair<number, number> factorise(const number &n, const number &base, const digit_counter &steps, const factorise_options &options)
+{
+    /* a prime would make the search run to exhaustion */
+    if(is_prime(n))
+    {
+        return make_pair(1, n);
+    }
+
+    number root = my_sqrt(n);
+
+    if(options.processes > 0 && root >= 2)
+    {
+        /* the shards of [2, root] */
+        uint64_t count = static_cast<uint64_t>(options.processes) * SHARDS_PER_PROCESS;
+        number size = (root - 2) / count + 1;
+        number x = from_mpz<number>(search_shards(count, options.processes, [&](uint64_t shard)
+        {
+            number low = 2 + size * shard;
+            number high = low + size - 1;
+            prime_sieve primes(from_mpz<uint64_t>(to_mpz(low)));
+
+            for(number p = primes.next();p <= high && p <= root;p = primes.next())
+            {
+                if(n % p == 0)
+                {
+                    return to_mpz(p);
+                }
+            }
+
+            return mpz_class(0);
+        }));
+
+        return (x != 0) ? make_pair(x, n / x) : make_pair(number(1), n);
+    }
+
+    /* the first prime which is tried, a resumed search continues after the
+     * last one of its checkpoint */
+    uint64_t start = 2;
+    string state;
+
+    if(options.checkpoint != NULL && options.checkpoint->start("trial_division", to_mpz(n), to_mpz(base), steps, state))
+    {
+        checkpoint_reader reader(state);
+
+        start = reader.get();
+
+        if(!reader.good() || !reader.at_end() || start < 2)
+        {
+            options.checkpoint->reject("damaged position");
+            start = 2;
+        }
+    }
+
+    prime_sieve primes(start);
+    uint64_t tried = 0;
+
+    /* the smallest factor is prime, so it suffices to try primes */
+    for(number x = primes.next();x <= root;x = primes.next())
+    {
+        if(n % x == 0)
+        {
+            return make_pair(x, n / x);
+        }
+
+        if((options.checkpoint == NULL && options.token == NULL) || ++tried % CHECKPOINT_POLL_INTERVAL != 0)
+        {
+            continue;
+        }
+
+        if(options.checkpoint != NULL && options.checkpoint->due())
+        {
+            checkpoint_writer position;
+
+            position.put(from_mpz<uint64_t>(to_mpz(x)) + 1);
+            options.checkpoint->save(position);
+        }
+
+        if(options.token != NULL)
+        {
+            options.token->cover(to_mpz(x).get_d() / to_mpz(root).get_d());
+
+            if(options.token->charge(CHECKPOINT_POLL_INTERVAL))
+            {
+                break;
+            }
+        }
+    }
+
+    return make_pair(1, n);
+}
+
+DEFINE_ENGINE(trial_division_engine, "trial", factorise, keep_base, square_root_bits, false, true, false, true, NULL)
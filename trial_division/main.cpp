@@ -17,28 +17,10 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-
-#include <iostream>
-
 #include "../common/common.h"
-
-using namespace std;
-
-pair<number, number> factorise(const number &n, const number &base, const digit_counter &steps)
-{
-    for(number x = 2;x <= my_sqrt(n);x++)
-    {
-        if(n % x == 0)
-        {
-            return make_pair(x, n / x);
-        }
-    }
-
-    return make_pair(1, n);
-}
+#include "../common/engine.h"
 
 int main(int argc, char *argv[])
 {
-    return common_main(argc, argv, false, true, false);
+    return common_main(argc, argv, trial_division_engine);
 }
-